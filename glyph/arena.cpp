@@ -0,0 +1,46 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+arena::arena(std::size_t const first_block_size)
+    : m_first_block_size{ first_block_size }
+{
+}
+
+auto arena::capacity() const noexcept -> std::size_t
+{
+    std::size_t total = 0;
+    for(auto const& b : m_blocks) {
+        total += b.size;
+    }
+    return total;
+}
+
+auto arena::do_allocate(std::size_t const bytes, std::size_t const alignment) -> void*
+{
+    // Try the current block, then the ones kept from before the last rewind, before growing.
+    for(; m_top.block < m_blocks.size(); ++m_top.block, m_top.offset = 0) {
+        auto& b = m_blocks[m_top.block];
+        auto const base = reinterpret_cast<std::uintptr_t>(b.data.get());
+        auto const start = (base + m_top.offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+
+        if(start + bytes <= base + b.size) {
+            m_top.offset = start - base + bytes;
+            return reinterpret_cast<void*>(start);
+        }
+    }
+
+    // Each new block at least doubles the arena, so a thread settles after a few glyphs.
+    std::size_t const size = std::max({ m_first_block_size, capacity(), bytes + alignment });
+    m_blocks.push_back(block{ std::make_unique<std::byte[]>(size), size });
+
+    m_top = mark{ m_blocks.size() - 1, 0 };
+    return do_allocate(bytes, alignment);
+}
+
+auto thread_arena() -> arena&
+{
+    thread_local arena instance;
+    return instance;
+}
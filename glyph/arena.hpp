@@ -0,0 +1,98 @@
+#ifndef BEZIER_ARENA_HPP
+#define BEZIER_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for per-glyph scratch. Allocation moves a pointer; nothing is freed until the
+// arena is rewound, and rewinding keeps the blocks, so once a thread has handled its largest
+// glyph it stops calling malloc. Use it through std::pmr containers and `arena_scope`.
+class arena : public std::pmr::memory_resource
+{
+public:
+    // Where the next allocation goes; `rewind` drops everything allocated after it.
+    struct mark
+    {
+        std::size_t block = 0;
+        std::size_t offset = 0;
+    };
+
+    explicit arena(std::size_t first_block_size = 64 * 1024);
+
+    arena(arena const&) = delete;
+    arena(arena&&) = delete;
+    ~arena() override = default;
+
+    auto operator=(arena const&) -> arena& = delete;
+    auto operator=(arena&&) -> arena& = delete;
+
+    [[nodiscard]] auto position() const noexcept -> mark
+    {
+        return m_top;
+    }
+
+    auto rewind(mark const to) noexcept -> void
+    {
+        m_top = to;
+    }
+
+    // Bytes held in blocks, used or not.
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+private:
+    struct block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+    auto do_deallocate(void*, std::size_t, std::size_t) -> void override {}
+    [[nodiscard]] auto do_is_equal(std::pmr::memory_resource const& other) const noexcept -> bool override
+    {
+        return this == &other;
+    }
+
+    std::vector<block> m_blocks;
+    std::size_t m_first_block_size;
+    mark m_top;
+};
+
+// The calling thread's arena.
+[[nodiscard]] auto thread_arena() -> arena&;
+
+// Rewinds the thread's arena to where it stood on construction. Containers allocated from it
+// inside the scope must be gone (or never touched again) by the time the scope ends.
+class arena_scope
+{
+public:
+    arena_scope()
+        : m_arena{ thread_arena() }
+        , m_mark{ m_arena.position() }
+    {
+    }
+
+    arena_scope(arena_scope const&) = delete;
+    arena_scope(arena_scope&&) = delete;
+
+    ~arena_scope()
+    {
+        m_arena.rewind(m_mark);
+    }
+
+    auto operator=(arena_scope const&) -> arena_scope& = delete;
+    auto operator=(arena_scope&&) -> arena_scope& = delete;
+
+    [[nodiscard]] auto resource() const noexcept -> std::pmr::memory_resource*
+    {
+        return &m_arena;
+    }
+
+private:
+    arena& m_arena;
+    arena::mark m_mark;
+};
+
+#endif // BEZIER_ARENA_HPP
@@ -0,0 +1,614 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include FT_OUTLINE_H
+
+#include "encode.hpp"
+#include "outline.hpp"
+#include "raster.hpp"
+#include "reference.hpp"
+#include "sdf.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct coverage_bitmap
+{
+    int width = 0;
+    int rows = 0;
+    int left = 0;
+    int top = 0;
+    // Bytes FreeType's own bitmap takes, rows padded to its pitch.
+    std::size_t bytes = 0;
+    std::vector<std::uint8_t> pixels;
+};
+
+template<typename F>
+auto best_time_us(int const repeats, F fn) -> double
+{
+    double best = 0.0;
+
+    for(int i = 0; i < repeats; ++i) {
+        auto const start = clock_type::now();
+        if(!fn()) {
+            return -1.0;
+        }
+        double const us = std::chrono::duration<double, std::micro>(clock_type::now() - start).count();
+        best = i == 0 ? us : std::min(best, us);
+    }
+
+    return best;
+}
+
+[[nodiscard]] auto render_freetype(FT_Face face, FT_UInt const index) -> bool
+{
+    return FT_Load_Glyph(face, index, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP) == 0 &&
+           FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) == 0;
+}
+
+auto copy_bitmap(FT_GlyphSlot slot, coverage_bitmap& out) -> void
+{
+    auto const& bitmap = slot->bitmap;
+
+    out.width = static_cast<int>(bitmap.width);
+    out.rows = static_cast<int>(bitmap.rows);
+    out.left = slot->bitmap_left;
+    out.top = slot->bitmap_top;
+    out.bytes = static_cast<std::size_t>(std::abs(bitmap.pitch)) * bitmap.rows;
+    out.pixels.resize(static_cast<std::size_t>(out.width) * out.rows);
+
+    for(int row = 0; row < out.rows; ++row) {
+        std::memcpy(out.pixels.data() + static_cast<std::size_t>(row) * out.width,
+                    bitmap.buffer + static_cast<std::ptrdiff_t>(row) * bitmap.pitch,
+                    static_cast<std::size_t>(out.width));
+    }
+}
+
+// Puts this renderer's samples on the centers of FreeType's pixels: bitmap column j spans
+// [left + j, left + j + 1) in pixel space, row i spans [top - i - 1, top - i).
+auto matching_params(coverage_bitmap const& bitmap, float const scale) -> raster_params
+{
+    raster_params params;
+    params.width = bitmap.width;
+    params.height = bitmap.rows;
+    params.scale = scale;
+    params.min_x = (bitmap.left + 0.5F) / scale;
+    params.min_y = (bitmap.top - bitmap.rows + 0.5F) / scale;
+    params.format = pixel_format::coverage;
+    return params;
+}
+
+// Rebuilds FreeType's view of `curves`: a new contour starts wherever a curve does not begin at
+// the end of the previous one. Coordinates become 26.6 pixels at `scale`, moved by `offset`
+// pixels.
+class ft_outline
+{
+public:
+    ft_outline(FT_Library library, std::vector<curve> const& curves, float const scale, point const offset = {})
+        : m_library{ library }
+    {
+        std::vector<std::size_t> ends;
+
+        for(std::size_t i = 0; i < curves.size(); ++i) {
+            if(i + 1 == curves.size() || curves[i + 1].p1.x != curves[i].p3.x || curves[i + 1].p1.y != curves[i].p3.y) {
+                ends.push_back(i);
+            }
+        }
+
+        // Every curve contributes its start and control point; the end point is the next
+        // curve's start, or the contour's first point again.
+        if(FT_Outline_New(library,
+                          static_cast<FT_UInt>(2 * curves.size()),
+                          static_cast<FT_Int>(ends.size()),
+                          &m_outline) != 0) {
+            m_valid = false;
+            return;
+        }
+
+        auto const to_ft = [scale, offset](point const p) {
+            return FT_Vector{ static_cast<FT_Pos>(std::lround((p.x * scale + offset.x) * 64.0F)),
+                              static_cast<FT_Pos>(std::lround((p.y * scale + offset.y) * 64.0F)) };
+        };
+
+        for(std::size_t i = 0; i < curves.size(); ++i) {
+            m_outline.points[2 * i] = to_ft(curves[i].p1);
+            m_outline.points[2 * i + 1] = to_ft(curves[i].p2);
+            m_outline.tags[2 * i] = FT_CURVE_TAG_ON;
+            m_outline.tags[2 * i + 1] = FT_CURVE_TAG_CONIC;
+        }
+        for(std::size_t i = 0; i < ends.size(); ++i) {
+            m_outline.contours[i] = static_cast<short>(2 * ends[i] + 1);
+        }
+    }
+
+    ft_outline(ft_outline const&) = delete;
+    ft_outline(ft_outline&&) = delete;
+
+    ~ft_outline()
+    {
+        if(m_valid) {
+            FT_Outline_Done(m_library, &m_outline);
+        }
+    }
+
+    auto operator=(ft_outline const&) -> ft_outline& = delete;
+    auto operator=(ft_outline&&) -> ft_outline& = delete;
+
+    [[nodiscard]] auto valid() const noexcept -> bool
+    {
+        return m_valid;
+    }
+
+    [[nodiscard]] auto get() noexcept -> FT_Outline*
+    {
+        return &m_outline;
+    }
+
+private:
+    FT_Library m_library;
+    FT_Outline m_outline{};
+    bool m_valid = true;
+};
+
+// Renders `outline` with FreeType's smooth rasterizer into an 8-bit `width` x `height` bitmap
+// covering [0, width) x [0, height) pixels, top row first.
+[[nodiscard]] auto render_freetype_outline(FT_Library library,
+                                           FT_Outline* outline,
+                                           int const width,
+                                           int const height,
+                                           std::uint8_t* dst) -> bool
+{
+    FT_Bitmap bitmap{};
+    bitmap.rows = static_cast<unsigned>(height);
+    bitmap.width = static_cast<unsigned>(width);
+    bitmap.pitch = width;
+    bitmap.buffer = dst;
+    bitmap.num_grays = 256;
+    bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
+
+    std::fill(dst, dst + static_cast<std::size_t>(width) * height, std::uint8_t{ 0 });
+
+    return FT_Outline_Get_Bitmap(library, outline, &bitmap) == 0;
+}
+
+// Moves the outline so FreeType's pixel centers land on the sample points of `grid`.
+auto freetype_offset(raster_params const& grid) -> point
+{
+    return point{ 0.5F - grid.min_x * grid.scale, 0.5F - grid.min_y * grid.scale };
+}
+
+// The distance field texels that sample the same points as `grid`, one thread.
+auto matching_field_params(raster_params const& grid, raster_backend const backend) -> distance_field_params
+{
+    distance_field_params params;
+    params.type = backend == raster_backend::msdf ? distance_field_type::msdf : distance_field_type::sdf;
+    params.width = grid.width;
+    params.height = grid.height;
+    params.min_x = grid.min_x - 0.5F / grid.scale;
+    params.min_y = grid.min_y - 0.5F / grid.scale;
+    params.scale = grid.scale;
+    params.threads = 1;
+    return params;
+}
+
+// Renders `curves` through `backend` on `grid` into `dst`, which holds width * height pixels of
+// the backend's channel count. `ft` is `curves` as built for FreeType with freetype_offset(grid).
+auto render_backend(raster_backend const backend,
+                    std::vector<curve> const& curves,
+                    raster_params const& grid,
+                    FT_Library library,
+                    FT_Outline* ft,
+                    std::uint8_t* dst) -> bool
+{
+    switch(backend) {
+    case raster_backend::coverage:
+        render_rows(curves, grid, 0, grid.height, dst, static_cast<std::size_t>(grid.width));
+        return true;
+    case raster_backend::sdf:
+    case raster_backend::msdf: {
+        auto const params = matching_field_params(grid, backend);
+        auto const stride = static_cast<std::size_t>(grid.width) * channel_count(params.type);
+        render_distance_field(curves, params, dst, stride);
+        return true;
+    }
+    case raster_backend::freetype:
+        return render_freetype_outline(library, ft, grid.width, grid.height, dst);
+    }
+    return false;
+}
+
+// Turns pixel `i` of a render_backend image back into coverage in 0..1. Distance fields cover
+// half a pixel of coverage ramp on each side of the edge, like a box-filtered edge.
+auto decode_coverage(raster_backend const backend, std::uint8_t const* pixels, std::size_t const i, float const range)
+    -> double
+{
+    auto const distance = [range](double const v) { return std::clamp(0.5 + (v / 255.0 - 0.5) * range, 0.0, 1.0); };
+
+    switch(backend) {
+    case raster_backend::coverage:
+    case raster_backend::freetype:
+        return pixels[i] / 255.0;
+    case raster_backend::sdf:
+        return distance(pixels[i]);
+    case raster_backend::msdf: {
+        auto const* const texel = pixels + 3 * i;
+        int const median = std::max(std::min(texel[0], texel[1]), std::min(std::max(texel[0], texel[1]), texel[2]));
+        return distance(median);
+    }
+    }
+    return 0.0;
+}
+
+// A grid of whole pixels around the outline at `scale`, with a pixel of margin and pixel
+// centers on half-integer pixel coordinates, the way FreeType places them.
+auto padded_params(glyph_outline const& outline, float const scale) -> raster_params
+{
+    int const left = static_cast<int>(std::floor(outline.min_x * scale)) - 1;
+    int const bottom = static_cast<int>(std::floor(outline.min_y * scale)) - 1;
+    int const right = static_cast<int>(std::ceil(outline.max_x * scale)) + 1;
+    int const top = static_cast<int>(std::ceil(outline.max_y * scale)) + 1;
+
+    raster_params params;
+    params.width = right - left;
+    params.height = top - bottom;
+    params.scale = scale;
+    params.min_x = (left + 0.5F) / scale;
+    params.min_y = (bottom + 0.5F) / scale;
+    params.format = pixel_format::coverage;
+    return params;
+}
+
+} // namespace
+
+auto compare_with_freetype(FT_Face face,
+                           std::vector<FT_ULong> const& chars,
+                           std::vector<int> const& sizes,
+                           int const repeats,
+                           std::vector<size_comparison>& results) -> bool
+{
+    results.clear();
+
+    coverage_bitmap reference;
+    glyph_outline outline;
+    std::vector<std::uint8_t> pixels;
+
+    for(auto const size : sizes) {
+        if(FT_Set_Pixel_Sizes(face, 0, static_cast<FT_UInt>(size)) != 0) {
+            spdlog::error("Could not set pixel size {}", size);
+            return false;
+        }
+
+        float const scale = static_cast<float>(size) / face->units_per_EM;
+
+        size_comparison result;
+        result.size = size;
+
+        std::size_t pixel_count = 0;
+        std::size_t off_pixels = 0;
+        double difference_sum = 0.0;
+
+        for(auto const c : chars) {
+            auto const index = FT_Get_Char_Index(face, c);
+
+            double const ft_us = best_time_us(repeats, [&]() { return render_freetype(face, index); });
+
+            if(ft_us < 0.0) {
+                spdlog::error("FreeType could not render glyph #{} at {}px", c, size);
+                return false;
+            }
+
+            copy_bitmap(face->glyph, reference);
+
+            if(reference.width == 0 || reference.rows == 0) {
+                continue;
+            }
+
+            auto const params = matching_params(reference, scale);
+            auto const stride = static_cast<std::size_t>(params.width);
+            pixels.resize(stride * params.height);
+
+            double const bezier_us = best_time_us(repeats, [&]() {
+                if(!load_glyph_outline_by_index(face, index, outline)) {
+                    return false;
+                }
+                render_rows(outline.curves, params, 0, params.height, pixels.data(), stride);
+                return true;
+            });
+
+            if(bezier_us < 0.0) {
+                return false;
+            }
+
+            for(std::size_t i = 0; i < pixels.size(); ++i) {
+                int const delta = std::abs(pixels[i] - reference.pixels[i]);
+                difference_sum += delta / 255.0;
+                result.max_difference = std::max(result.max_difference, delta / 255.0);
+                off_pixels += delta > 1 ? 1 : 0;
+            }
+
+            ++result.glyphs;
+            pixel_count += pixels.size();
+            result.freetype_us += ft_us;
+            result.bezier_us += bezier_us;
+            result.freetype_bytes += static_cast<double>(reference.bytes);
+            result.bezier_bytes += static_cast<double>(pixels.size() + outline.curves.size() * sizeof(curve));
+        }
+
+        if(result.glyphs > 0) {
+            auto const n = static_cast<double>(result.glyphs);
+            result.freetype_us /= n;
+            result.bezier_us /= n;
+            result.freetype_bytes /= n;
+            result.bezier_bytes /= n;
+            result.mean_difference = difference_sum / pixel_count;
+            result.off_pixels_percent = 100.0 * off_pixels / pixel_count;
+        }
+
+        results.push_back(result);
+    }
+
+    return true;
+}
+
+auto log_size_comparison(std::vector<size_comparison> const& results) -> void
+{
+    spdlog::info("{:>5} {:>6} {:>11} {:>11} {:>8} {:>9} {:>9} {:>9} {:>9} {:>7}",
+                 "px",
+                 "glyphs",
+                 "ft us",
+                 "bezier us",
+                 "speedup",
+                 "ft B",
+                 "bezier B",
+                 "mean diff",
+                 "max diff",
+                 "off %");
+
+    for(auto const& r : results) {
+        spdlog::info("{:>5} {:>6} {:>11.2f} {:>11.2f} {:>7.2f}x {:>9.0f} {:>9.0f} {:>9.4f} {:>9.4f} {:>7.2f}",
+                     r.size,
+                     r.glyphs,
+                     r.freetype_us,
+                     r.bezier_us,
+                     r.bezier_us > 0.0 ? r.freetype_us / r.bezier_us : 0.0,
+                     r.freetype_bytes,
+                     r.bezier_bytes,
+                     r.mean_difference,
+                     r.max_difference,
+                     r.off_pixels_percent);
+    }
+}
+
+auto raster_backend_name(raster_backend const backend) -> char const*
+{
+    switch(backend) {
+    case raster_backend::coverage:
+        return "coverage";
+    case raster_backend::sdf:
+        return "sdf";
+    case raster_backend::msdf:
+        return "msdf";
+    case raster_backend::freetype:
+        return "freetype";
+    }
+    return "unknown";
+}
+
+auto run_scaling_study(synthetic_params const& shape,
+                       std::vector<int> const& curve_counts,
+                       std::vector<int> const& sizes,
+                       int const repeats,
+                       std::vector<scaling_sample>& samples) -> bool
+{
+    samples.clear();
+
+    FT_Library library = nullptr;
+
+    if(FT_Init_FreeType(&library) != 0) {
+        spdlog::error("Couldn't initialize Freetype!");
+        return false;
+    }
+
+    bool ok = true;
+    glyph_outline outline;
+    std::vector<std::uint8_t> pixels;
+
+    for(auto const count : curve_counts) {
+        auto params = shape;
+        params.curves = static_cast<std::size_t>(count);
+        generate_outline(params, outline);
+
+        for(auto const size : sizes) {
+            auto const scale = static_cast<float>(size) / shape.extent;
+            raster_params const grid{ size, size, 0.0F, 0.0F, scale, pixel_format::coverage };
+            ft_outline ft{ library, outline.curves, grid.scale, freetype_offset(grid) };
+
+            if(!ft.valid()) {
+                ok = false;
+                break;
+            }
+
+            pixels.resize(static_cast<std::size_t>(size) * size * 3);
+
+            for(std::size_t b = 0; b < raster_backend_count; ++b) {
+                auto const backend = static_cast<raster_backend>(b);
+
+                double const us = best_time_us(repeats, [&]() {
+                    return render_backend(backend, outline.curves, grid, library, ft.get(), pixels.data());
+                });
+
+                if(us < 0.0) {
+                    spdlog::error("{} failed on {} curves at {}px", raster_backend_name(backend), count, size);
+                    ok = false;
+                    continue;
+                }
+
+                samples.push_back(scaling_sample{ backend, outline.curves.size(), size, us / 1000.0 });
+                spdlog::info("{:>9} {:>7} curves {:>5}px {:>12.3f} ms",
+                             raster_backend_name(backend),
+                             outline.curves.size(),
+                             size,
+                             us / 1000.0);
+            }
+        }
+    }
+
+    FT_Done_FreeType(library);
+    return ok;
+}
+
+auto write_scaling_csv(char const* filename, std::vector<scaling_sample> const& samples) -> bool
+{
+    std::string csv = "backend,curves,size,ms\n";
+
+    for(auto const& s : samples) {
+        csv += fmt::format("{},{},{},{:.6f}\n", raster_backend_name(s.backend), s.curves, s.size, s.ms);
+    }
+
+    return write_file(filename, std::vector<std::uint8_t>(csv.begin(), csv.end()));
+}
+
+auto measure_quality(FT_Face face,
+                     std::vector<FT_ULong> const& chars,
+                     std::vector<int> const& sizes,
+                     int const samples,
+                     int const repeats,
+                     std::vector<quality_result>& results) -> bool
+{
+    results.clear();
+
+    FT_Library const library = face->glyph->library;
+    glyph_outline outline;
+    std::vector<float> reference;
+    std::vector<std::uint8_t> pixels;
+
+    for(auto const size : sizes) {
+        float const scale = static_cast<float>(size) / face->units_per_EM;
+
+        std::array<quality_result, raster_backend_count> by_backend;
+        std::array<double, raster_backend_count> squared{};
+
+        for(auto const c : chars) {
+            if(!load_glyph_outline(face, c, outline)) {
+                return false;
+            }
+            if(outline.curves.empty()) {
+                continue;
+            }
+
+            auto const grid = padded_params(outline, scale);
+            ft_outline ft{ library, outline.curves, scale, freetype_offset(grid) };
+
+            if(!ft.valid()) {
+                spdlog::error("FreeType could not hold the outline of glyph #{}", c);
+                return false;
+            }
+
+            render_reference(outline.curves, grid, samples, reference);
+            pixels.resize(reference.size() * 3);
+
+            for(std::size_t b = 0; b < raster_backend_count; ++b) {
+                auto const backend = static_cast<raster_backend>(b);
+                auto& result = by_backend[b];
+
+                double const us = best_time_us(repeats, [&]() {
+                    return render_backend(backend, outline.curves, grid, library, ft.get(), pixels.data());
+                });
+
+                if(us < 0.0) {
+                    spdlog::error("{} could not render glyph #{} at {}px", raster_backend_name(backend), c, size);
+                    return false;
+                }
+
+                float const range = matching_field_params(grid, backend).range;
+
+                for(std::size_t i = 0; i < reference.size(); ++i) {
+                    double const error = std::abs(decode_coverage(backend, pixels.data(), i, range) - reference[i]);
+                    result.max_error = std::max(result.max_error, error);
+                    result.mean_error += error;
+                    squared[b] += error * error;
+                    result.off_pixels_percent += error > 1.0 / 255.0 ? 1.0 : 0.0;
+                }
+
+                ++result.glyphs;
+                result.pixels += reference.size();
+                result.us += us;
+            }
+        }
+
+        for(std::size_t b = 0; b < raster_backend_count; ++b) {
+            auto& result = by_backend[b];
+            result.backend = static_cast<raster_backend>(b);
+            result.size = size;
+
+            if(result.glyphs > 0) {
+                auto const n = static_cast<double>(result.pixels);
+                result.us /= static_cast<double>(result.glyphs);
+                result.mean_error /= n;
+                result.rms_error = std::sqrt(squared[b] / n);
+                result.off_pixels_percent *= 100.0 / n;
+            }
+
+            results.push_back(result);
+        }
+    }
+
+    return true;
+}
+
+auto log_quality(std::vector<quality_result> const& results) -> void
+{
+    spdlog::info("{:>9} {:>5} {:>6} {:>11} {:>9} {:>9} {:>9} {:>7}",
+                 "mode",
+                 "px",
+                 "glyphs",
+                 "us/glyph",
+                 "max err",
+                 "mean err",
+                 "rms err",
+                 "off %");
+
+    for(auto const& r : results) {
+        spdlog::info("{:>9} {:>5} {:>6} {:>11.2f} {:>9.4f} {:>9.4f} {:>9.4f} {:>7.2f}",
+                     raster_backend_name(r.backend),
+                     r.size,
+                     r.glyphs,
+                     r.us,
+                     r.max_error,
+                     r.mean_error,
+                     r.rms_error,
+                     r.off_pixels_percent);
+    }
+}
+
+auto parse_size_list(std::string const& value, std::vector<int>& sizes) -> bool
+{
+    sizes.clear();
+
+    char const* p = value.c_str();
+
+    while(*p != '\0') {
+        char* end = nullptr;
+        auto const size = std::strtol(p, &end, 10);
+
+        if(end == p || size <= 0 || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+
+        sizes.push_back(static_cast<int>(size));
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    return !sizes.empty();
+}
@@ -0,0 +1,103 @@
+#ifndef BEZIER_BENCHMARK_HPP
+#define BEZIER_BENCHMARK_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "synthetic.hpp"
+
+constexpr int default_benchmark_sizes[] = { 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512 };
+
+// One size bucket of `compare_with_freetype`, averaged over the glyphs that have an outline.
+// Times cover loading the glyph and rendering it, best of `repeats`. Memory is what each path
+// needs to hold per glyph: the bitmap for FreeType, the bitmap plus the curve list here.
+// Coverage differences are in 0..1 over the shared pixel grid.
+struct size_comparison
+{
+    int size = 0;
+    std::size_t glyphs = 0;
+    double freetype_us = 0.0;
+    double bezier_us = 0.0;
+    double freetype_bytes = 0.0;
+    double bezier_bytes = 0.0;
+    double mean_difference = 0.0;
+    double max_difference = 0.0;
+    double off_pixels_percent = 0.0;
+};
+
+// Renders every character of `chars` at every pixel size through FT_Render_Glyph (unhinted,
+// FT_RENDER_MODE_NORMAL) and through `render_rows`, on the same pixel grid.
+[[nodiscard]] auto compare_with_freetype(FT_Face face,
+                                         std::vector<FT_ULong> const& chars,
+                                         std::vector<int> const& sizes,
+                                         int repeats,
+                                         std::vector<size_comparison>& results) -> bool;
+
+auto log_size_comparison(std::vector<size_comparison> const& results) -> void;
+
+[[nodiscard]] auto parse_size_list(std::string const& value, std::vector<int>& sizes) -> bool;
+
+enum class raster_backend
+{
+    coverage,
+    sdf,
+    msdf,
+    freetype
+};
+
+constexpr std::size_t raster_backend_count = 4;
+
+[[nodiscard]] auto raster_backend_name(raster_backend backend) -> char const*;
+
+struct scaling_sample
+{
+    raster_backend backend = raster_backend::coverage;
+    std::size_t curves = 0;
+    int size = 0;
+    double ms = 0.0;
+};
+
+// Times every backend on synthetic outlines of each curve count, rendered to square images of
+// each size, all on one thread. Everything except the curve count comes from `shape`.
+[[nodiscard]] auto run_scaling_study(synthetic_params const& shape,
+                                     std::vector<int> const& curve_counts,
+                                     std::vector<int> const& sizes,
+                                     int repeats,
+                                     std::vector<scaling_sample>& samples) -> bool;
+
+// One "backend,curves,size,ms" row per sample, for plotting.
+[[nodiscard]] auto write_scaling_csv(char const* filename, std::vector<scaling_sample> const& samples) -> bool;
+
+// One backend at one size in `measure_quality`, over every glyph with an outline. Errors are
+// in coverage (0..1) against the supersampled reference; distance fields are decoded to
+// coverage first. Times are per glyph, rendering only, best of `repeats`.
+struct quality_result
+{
+    raster_backend backend = raster_backend::coverage;
+    int size = 0;
+    std::size_t glyphs = 0;
+    std::size_t pixels = 0;
+    double us = 0.0;
+    double max_error = 0.0;
+    double mean_error = 0.0;
+    double rms_error = 0.0;
+    // Pixels more than 1/255 away from the reference.
+    double off_pixels_percent = 0.0;
+};
+
+// Renders every character of `chars` at every pixel size through each backend and through
+// render_reference with `samples` x `samples` points per pixel, all on the same grid.
+[[nodiscard]] auto measure_quality(FT_Face face,
+                                   std::vector<FT_ULong> const& chars,
+                                   std::vector<int> const& sizes,
+                                   int samples,
+                                   int repeats,
+                                   std::vector<quality_result>& results) -> bool;
+
+auto log_quality(std::vector<quality_result> const& results) -> void;
+
+#endif // BEZIER_BENCHMARK_HPP
@@ -0,0 +1,206 @@
+#ifndef BEZIER_BOUNDED_QUEUE_HPP
+#define BEZIER_BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bounded multi-producer multi-consumer queue (Vyukov's array queue): every slot carries a
+// sequence number that tells producers and consumers whose turn it is, so try_push and try_pop
+// are a single CAS on the shared position in the common case and never take a lock. The
+// blocking push and pop spin briefly, then sleep on a condition variable; the mutex is only
+// touched when some thread is actually asleep.
+template<typename T>
+class bounded_queue
+{
+public:
+    explicit bounded_queue(std::size_t capacity)
+        : m_mask{ round_up(capacity) - 1 }
+        , m_slots(m_mask + 1)
+    {
+        for(std::size_t i = 0; i <= m_mask; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] auto try_push(T& value) -> bool
+    {
+        auto pos = m_enqueue.load(std::memory_order_relaxed);
+
+        while(true) {
+            auto& slot = m_slots[pos & m_mask];
+            auto const seq = slot.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+            if(diff == 0) {
+                if(m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    [[nodiscard]] auto try_pop(T& value) -> bool
+    {
+        auto pos = m_dequeue.load(std::memory_order_relaxed);
+
+        while(true) {
+            auto& slot = m_slots[pos & m_mask];
+            auto const seq = slot.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+            if(diff == 0) {
+                if(m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(slot.value);
+                    slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_dequeue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Waits until there is room.
+    auto push(T value) -> void
+    {
+        for(int spin = 0; spin < spin_limit; ++spin) {
+            if(try_push(value)) {
+                wake(m_pop_waiters, m_not_empty);
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_push_waiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_not_full.wait(lock, [&] { return try_push(value); });
+            m_push_waiters.fetch_sub(1);
+        }
+        wake(m_pop_waiters, m_not_empty);
+    }
+
+    // Approximate number of queued items; exact only when the queue is quiescent.
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        auto const enq = m_enqueue.load(std::memory_order_relaxed);
+        auto const deq = m_dequeue.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t
+    {
+        return m_mask + 1;
+    }
+
+    // Marks that no more items will be pushed. Consumers finish draining before they stop.
+    auto close() -> void
+    {
+        m_closed.store(true, std::memory_order_seq_cst);
+
+        std::lock_guard<std::mutex> const lock{ m_mutex };
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+    [[nodiscard]] auto closed() const noexcept -> bool
+    {
+        return m_closed.load(std::memory_order_acquire);
+    }
+
+    // Waits for an item; returns false once the queue is closed and empty.
+    [[nodiscard]] auto pop(T& value) -> bool
+    {
+        for(int spin = 0; spin < spin_limit && !closed(); ++spin) {
+            if(try_pop(value)) {
+                wake(m_push_waiters, m_not_full);
+                return true;
+            }
+            std::this_thread::yield();
+        }
+
+        bool popped = false;
+
+        if(!closed()) {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_pop_waiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_not_empty.wait(lock, [&] {
+                popped = try_pop(value);
+                return popped || closed();
+            });
+            m_pop_waiters.fetch_sub(1);
+        }
+
+        // Items pushed before close() are visible now; one last look.
+        if(!popped) {
+            popped = try_pop(value);
+        }
+        if(popped) {
+            wake(m_push_waiters, m_not_full);
+        }
+        return popped;
+    }
+
+private:
+    // Failed attempts, each followed by a yield, before a blocking call goes to sleep.
+    static constexpr int spin_limit = 64;
+
+    struct slot
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    // The fence pairs with the one a sleeper issues after registering: either the sleeper sees
+    // the item or slot this thread just published, or this thread sees the sleeper.
+    auto wake(std::atomic<std::size_t>& waiters, std::condition_variable& sleepers) -> void
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if(waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> const lock{ m_mutex };
+            sleepers.notify_one();
+        }
+    }
+
+    static auto round_up(std::size_t n) -> std::size_t
+    {
+        std::size_t p = 2;
+        while(p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    std::size_t m_mask;
+    std::vector<slot> m_slots;
+    alignas(64) std::atomic<std::size_t> m_enqueue{ 0 };
+    alignas(64) std::atomic<std::size_t> m_dequeue{ 0 };
+    std::atomic<bool> m_closed{ false };
+    std::atomic<std::size_t> m_push_waiters{ 0 };
+    std::atomic<std::size_t> m_pop_waiters{ 0 };
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+};
+
+#endif // BEZIER_BOUNDED_QUEUE_HPP
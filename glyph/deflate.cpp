@@ -0,0 +1,190 @@
+#include "deflate.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include "parallel.hpp"
+#include "stb_image_write.h"
+#include "trace.hpp"
+
+namespace {
+
+constexpr std::size_t dictionary_size = 32 * 1024;
+
+std::mutex g_settings_mutex;
+deflate_settings g_settings;
+
+struct compressed_chunk
+{
+    std::vector<unsigned char> data;
+    uLong adler = 1;
+    std::size_t size = 0;
+    bool ok = false;
+};
+
+auto compress_chunk(unsigned char const* data,
+                    std::size_t const offset,
+                    std::size_t const size,
+                    bool const last,
+                    int const level,
+                    compressed_chunk& out) -> void
+{
+    z_stream zs{};
+
+    if(deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return;
+    }
+
+    if(offset > 0) {
+        auto const dict = std::min(offset, dictionary_size);
+        deflateSetDictionary(&zs, data + offset - dict, static_cast<uInt>(dict));
+    }
+
+    // Leave room for the sync flush marker and the block headers of incompressible data.
+    out.data.resize(deflateBound(&zs, static_cast<uLong>(size)) + 16);
+    out.size = size;
+
+    zs.next_in = const_cast<unsigned char*>(data + offset);
+    zs.avail_in = static_cast<uInt>(size);
+    zs.next_out = out.data.data();
+    zs.avail_out = static_cast<uInt>(out.data.size());
+
+    auto const status = deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+
+    out.ok = last ? status == Z_STREAM_END : (status == Z_OK && zs.avail_in == 0);
+    out.data.resize(out.data.size() - zs.avail_out);
+    out.adler = adler32(1L, data + offset, static_cast<uInt>(size));
+
+    deflateEnd(&zs);
+}
+
+} // namespace
+
+auto parse_compression_preset(std::string const& name, compression_preset& preset) -> bool
+{
+    if(name == "fastest") {
+        preset = compression_preset::fastest;
+    }
+    else if(name == "fast") {
+        preset = compression_preset::fast;
+    }
+    else if(name == "balanced") {
+        preset = compression_preset::balanced;
+    }
+    else if(name == "smallest") {
+        preset = compression_preset::smallest;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+auto make_deflate_settings(compression_preset const preset) -> deflate_settings
+{
+    deflate_settings settings;
+
+    switch(preset) {
+    case compression_preset::fastest: {
+        settings.level = 1;
+        settings.chunk_size = 64 * 1024;
+        break;
+    }
+    case compression_preset::fast: {
+        settings.level = 3;
+        settings.chunk_size = 128 * 1024;
+        break;
+    }
+    case compression_preset::balanced: {
+        settings.level = 6;
+        settings.chunk_size = 128 * 1024;
+        break;
+    }
+    case compression_preset::smallest: {
+        settings.level = 9;
+        settings.chunk_size = 1024 * 1024;
+        break;
+    }
+    }
+
+    return settings;
+}
+
+auto set_deflate_settings(deflate_settings const& settings) -> void
+{
+    std::lock_guard<std::mutex> lock{ g_settings_mutex };
+    g_settings = settings;
+    g_settings.level = std::clamp(settings.level, 0, 9);
+    stbi_write_png_compression_level = g_settings.level;
+}
+
+auto get_deflate_settings() -> deflate_settings
+{
+    std::lock_guard<std::mutex> lock{ g_settings_mutex };
+    return g_settings;
+}
+
+auto parallel_zlib_compress(unsigned char* data, int const data_len, int* out_len, int const quality)
+    -> unsigned char*
+{
+    auto const settings = get_deflate_settings();
+    auto const len = static_cast<std::size_t>(std::max(data_len, 0));
+    auto const chunk_size = std::max<std::size_t>(settings.chunk_size, dictionary_size);
+    auto const num_chunks = std::max<std::size_t>((len + chunk_size - 1) / chunk_size, 1);
+    int const level = std::clamp(quality, 0, 9);
+
+    std::vector<compressed_chunk> chunks(num_chunks);
+
+    parallel_for(num_chunks, settings.threads, [&](std::size_t const i) {
+        trace_span const span{ "deflate chunk", "encode", "chunk", static_cast<std::int64_t>(i) };
+
+        auto const offset = i * chunk_size;
+        auto const size = std::min(chunk_size, len - std::min(offset, len));
+        compress_chunk(data, offset, size, i + 1 == num_chunks, level, chunks[i]);
+    });
+
+    std::size_t total = 2 + 4;
+    uLong adler = 1;
+    for(auto const& chunk : chunks) {
+        if(!chunk.ok) {
+            spdlog::error("Parallel deflate failed!");
+            return nullptr;
+        }
+        total += chunk.data.size();
+        adler = adler32_combine(adler, chunk.adler, static_cast<z_off_t>(chunk.size));
+    }
+
+    auto* out = static_cast<unsigned char*>(std::malloc(total));
+    if(out == nullptr) {
+        return nullptr;
+    }
+
+    // zlib header: 32K window, deflate, FLEVEL picked from the level, FCHECK making it % 31 == 0.
+    int const flevel = level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+    int const cmf = 0x78;
+    int flg = flevel << 6;
+    flg += (31 - ((cmf * 256 + flg) % 31)) % 31;
+    out[0] = static_cast<unsigned char>(cmf);
+    out[1] = static_cast<unsigned char>(flg);
+
+    std::size_t pos = 2;
+    for(auto const& chunk : chunks) {
+        std::memcpy(out + pos, chunk.data.data(), chunk.data.size());
+        pos += chunk.data.size();
+    }
+
+    out[pos++] = static_cast<unsigned char>(adler >> 24);
+    out[pos++] = static_cast<unsigned char>(adler >> 16);
+    out[pos++] = static_cast<unsigned char>(adler >> 8);
+    out[pos++] = static_cast<unsigned char>(adler);
+
+    *out_len = static_cast<int>(pos);
+    return out;
+}
@@ -0,0 +1,37 @@
+#ifndef BEZIER_DEFLATE_HPP
+#define BEZIER_DEFLATE_HPP
+
+#include <cstddef>
+#include <string>
+
+enum class compression_preset
+{
+    fastest,
+    fast,
+    balanced,
+    smallest
+};
+
+struct deflate_settings
+{
+    int level = 8;
+    unsigned threads = 0;
+    std::size_t chunk_size = 128 * 1024;
+};
+
+[[nodiscard]] auto parse_compression_preset(std::string const& name, compression_preset& preset) -> bool;
+[[nodiscard]] auto make_deflate_settings(compression_preset preset) -> deflate_settings;
+
+// Settings used by `parallel_zlib_compress`. The level is also mirrored into
+// `stbi_write_png_compression_level` so stb and the streaming writer agree.
+auto set_deflate_settings(deflate_settings const& settings) -> void;
+[[nodiscard]] auto get_deflate_settings() -> deflate_settings;
+
+// Drop-in for stb_image_write's zlib compressor (see STBIW_ZLIB_COMPRESS in stb.cpp).
+// The input is split into `chunk_size` pieces which are deflated on worker threads, each one
+// primed with the previous 32 KiB as a dictionary and terminated with a sync flush, then
+// concatenated into a single standard zlib stream, like pigz does. The result is allocated
+// with malloc() so stb can release it with STBIW_FREE.
+auto parallel_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality) -> unsigned char*;
+
+#endif // BEZIER_DEFLATE_HPP
@@ -0,0 +1,268 @@
+#include "encode.hpp"
+
+#include <cstdio>
+#include <memory_resource>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define BEZIER_HAS_MMAP 1
+#else
+#define BEZIER_HAS_MMAP 0
+#endif
+
+#include "arena.hpp"
+#include "metrics.hpp"
+#include "stb_image_write.h"
+
+namespace {
+
+auto append_to_vector(void* context, void* data, int const size) -> void
+{
+    auto& out = *static_cast<std::vector<std::uint8_t>*>(context);
+    auto const* bytes = static_cast<std::uint8_t const*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+template<typename Buffer>
+auto append_rows(image_view const& image, Buffer& out) -> void
+{
+    auto const row_bytes = static_cast<std::size_t>(image.width) * image.channels;
+
+    for(int y = 0; y < image.height; ++y) {
+        auto const* row = image.pixels + static_cast<std::size_t>(y) * image.stride;
+        out.insert(out.end(), row, row + row_bytes);
+    }
+}
+
+// stb's BMP/TGA writers take no stride, so padded images are compacted first.
+auto contiguous_pixels(image_view const& image, std::pmr::vector<std::uint8_t>& scratch) -> std::uint8_t const*
+{
+    if(image.stride == static_cast<std::size_t>(image.width) * image.channels) {
+        return image.pixels;
+    }
+    scratch.clear();
+    append_rows(image, scratch);
+    return scratch.data();
+}
+
+} // namespace
+
+auto parse_image_format(std::string const& name, image_format& format) -> bool
+{
+    if(name == "png") {
+        format = image_format::png;
+    }
+    else if(name == "raw") {
+        format = image_format::raw;
+    }
+    else if(name == "pgm") {
+        format = image_format::pgm;
+    }
+    else if(name == "ppm") {
+        format = image_format::ppm;
+    }
+    else if(name == "pam") {
+        format = image_format::pam;
+    }
+    else if(name == "bmp") {
+        format = image_format::bmp;
+    }
+    else if(name == "tga") {
+        format = image_format::tga;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+auto is_uncompressed_layout(image_format const format, pixel_format const pixels) -> bool
+{
+    switch(format) {
+    case image_format::raw:
+    case image_format::pam: {
+        return true;
+    }
+    case image_format::pgm: {
+        return pixels == pixel_format::coverage;
+    }
+    default: {
+        return false;
+    }
+    }
+}
+
+auto netpbm_header(image_format const format, int const width, int const height, int const channels) -> std::string
+{
+    switch(format) {
+    case image_format::pgm: {
+        return fmt::format("P5\n{} {}\n255\n", width, height);
+    }
+    case image_format::ppm: {
+        return fmt::format("P6\n{} {}\n255\n", width, height);
+    }
+    case image_format::pam: {
+        return fmt::format("P7\nWIDTH {}\nHEIGHT {}\nDEPTH {}\nMAXVAL 255\nTUPLTYPE {}\nENDHDR\n",
+                           width,
+                           height,
+                           channels,
+                           channels == 1 ? "GRAYSCALE" : (channels == 3 ? "RGB" : "RGB_ALPHA"));
+    }
+    default: {
+        return std::string{};
+    }
+    }
+}
+
+auto encode_png(image_view const& image, std::vector<std::uint8_t>& out) -> bool
+{
+    phase_timer const timer{ phase::encode };
+
+    out.clear();
+
+    auto const ok = stbi_write_png_to_func(append_to_vector,
+                                           &out,
+                                           image.width,
+                                           image.height,
+                                           image.channels,
+                                           image.pixels,
+                                           static_cast<int>(image.stride));
+
+    if(ok == 0) {
+        spdlog::error("Could not encode {}x{} image as PNG!", image.width, image.height);
+        return false;
+    }
+
+    return true;
+}
+
+auto encode_image(image_view const& image, image_format const format, std::vector<std::uint8_t>& out) -> bool
+{
+    if(format == image_format::png) {
+        return encode_png(image, out);
+    }
+
+    phase_timer const timer{ phase::encode };
+
+    out.clear();
+
+    if(format == image_format::pgm && image.channels != 1) {
+        spdlog::error("PGM output needs coverage pixels (--format coverage)!");
+        return false;
+    }
+    if(format == image_format::ppm && image.channels != 3 && image.channels != 4) {
+        spdlog::error("PPM output needs rgb or rgba pixels!");
+        return false;
+    }
+
+    if(format == image_format::bmp || format == image_format::tga) {
+        arena_scope const arena;
+        std::pmr::vector<std::uint8_t> scratch{ arena.resource() };
+        auto const* pixels = contiguous_pixels(image, scratch);
+        auto const ok = format == image_format::bmp
+                            ? stbi_write_bmp_to_func(
+                                  append_to_vector, &out, image.width, image.height, image.channels, pixels)
+                            : stbi_write_tga_to_func(
+                                  append_to_vector, &out, image.width, image.height, image.channels, pixels);
+        if(ok == 0) {
+            spdlog::error("Could not encode {}x{} image!", image.width, image.height);
+            return false;
+        }
+        return true;
+    }
+
+    auto const header = netpbm_header(format, image.width, image.height, image.channels);
+    out.insert(out.end(), header.begin(), header.end());
+
+    if(format == image_format::ppm && image.channels == 4) {
+        out.reserve(out.size() + static_cast<std::size_t>(image.width) * image.height * 3);
+        for(int y = 0; y < image.height; ++y) {
+            auto const* row = image.pixels + static_cast<std::size_t>(y) * image.stride;
+            for(int x = 0; x < image.width; ++x) {
+                out.insert(out.end(), row + x * 4, row + x * 4 + 3);
+            }
+        }
+        return true;
+    }
+
+    append_rows(image, out);
+    return true;
+}
+
+auto write_file(char const* filename, std::vector<std::uint8_t> const& data) -> bool
+{
+    phase_timer const timer{ phase::write };
+
+    std::FILE* file = std::fopen(filename, "wb");
+
+    if(file == nullptr) {
+        spdlog::error("Could not open {} for writing!", filename);
+        return false;
+    }
+
+    bool const ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+    return (std::fclose(file) == 0) && ok;
+}
+
+mapped_file::~mapped_file()
+{
+    static_cast<void>(close());
+}
+
+auto mapped_file::open(char const* filename, std::size_t const size) -> bool
+{
+#if BEZIER_HAS_MMAP
+    m_fd = ::open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(m_fd < 0) {
+        spdlog::error("Could not open {} for writing!", filename);
+        return false;
+    }
+
+    if(::ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+        spdlog::error("Could not resize {} to {} bytes!", filename, size);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if(data == MAP_FAILED) {
+        spdlog::error("Could not map {} into memory!", filename);
+        return false;
+    }
+
+    m_data = static_cast<std::uint8_t*>(data);
+    m_size = size;
+    return true;
+#else
+    static_cast<void>(filename);
+    static_cast<void>(size);
+    spdlog::error("Memory-mapped output is not supported on this platform!");
+    return false;
+#endif
+}
+
+auto mapped_file::close() -> bool
+{
+    phase_timer const timer{ phase::write };
+
+    bool ok = true;
+
+#if BEZIER_HAS_MMAP
+    if(m_data != nullptr) {
+        ok = ::munmap(m_data, m_size) == 0;
+        m_data = nullptr;
+        m_size = 0;
+    }
+    if(m_fd >= 0) {
+        ok = (::close(m_fd) == 0) && ok;
+        m_fd = -1;
+    }
+#endif
+
+    return ok;
+}
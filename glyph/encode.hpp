@@ -0,0 +1,76 @@
+#ifndef BEZIER_ENCODE_HPP
+#define BEZIER_ENCODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "raster.hpp"
+
+// `raw` is bare rows with no header. pgm/ppm/pam are the binary netpbm variants: pgm needs
+// single-channel pixels, ppm drops alpha from rgba, pam stores anything as-is.
+enum class image_format
+{
+    png,
+    raw,
+    pgm,
+    ppm,
+    pam,
+    bmp,
+    tga
+};
+
+[[nodiscard]] auto parse_image_format(std::string const& name, image_format& format) -> bool;
+
+// True when the file is a header followed by the rows exactly as the renderer lays them out,
+// so rows can be rendered straight into the file (see `mapped_file`).
+[[nodiscard]] auto is_uncompressed_layout(image_format format, pixel_format pixels) -> bool;
+
+// Header that precedes the pixel rows, empty for formats without one.
+[[nodiscard]] auto netpbm_header(image_format format, int width, int height, int channels) -> std::string;
+
+// Encodes `image` as PNG into `out` without touching the filesystem. `out` is cleared first but
+// keeps its capacity, so a buffer reused across calls stops reallocating once it has grown to
+// the largest image seen.
+[[nodiscard]] auto encode_png(image_view const& image, std::vector<std::uint8_t>& out) -> bool;
+
+// Same contract as `encode_png`, for any of the supported formats.
+[[nodiscard]] auto encode_image(image_view const& image, image_format format, std::vector<std::uint8_t>& out)
+    -> bool;
+
+[[nodiscard]] auto write_file(char const* filename, std::vector<std::uint8_t> const& data) -> bool;
+
+// A file of fixed size mapped read-write into memory. Whatever is written through `data()` is
+// the file content once `close()` returns; nothing is copied through an intermediate buffer.
+class mapped_file
+{
+public:
+    mapped_file() = default;
+    mapped_file(mapped_file const&) = delete;
+    mapped_file(mapped_file&&) = delete;
+    ~mapped_file();
+
+    auto operator=(mapped_file const&) -> mapped_file& = delete;
+    auto operator=(mapped_file&&) -> mapped_file& = delete;
+
+    [[nodiscard]] auto open(char const* filename, std::size_t size) -> bool;
+    [[nodiscard]] auto close() -> bool;
+
+    [[nodiscard]] auto data() noexcept -> std::uint8_t*
+    {
+        return m_data;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_size;
+    }
+
+private:
+    std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    int m_fd = -1;
+};
+
+#endif // BEZIER_ENCODE_HPP
@@ -1,8 +1,12 @@
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
-#include <functional>
-#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include <fmt/format.h>
@@ -10,255 +14,804 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include FT_OUTLINE_H
 
-#include "stb_image_write.h"
+#include "benchmark.hpp"
+#include "deflate.hpp"
+#include "encode.hpp"
+#include "metrics.hpp"
+#include "outline.hpp"
+#include "pipeline.hpp"
+#include "png_stream.hpp"
+#include "raster.hpp"
+#include "reference.hpp"
+#include "sdf.hpp"
+#include "server.hpp"
+#include "synthetic.hpp"
+#include "trace.hpp"
+
+struct options
+{
+    std::vector<std::string> font_paths;
+    FT_ULong char_code = 87;
+    std::string output_path = "img.png";
+    float scale = 1.0F;
+    int band_height = 0;
+    deflate_settings deflate;
+    png_filter_mode filter = png_filter_mode::adaptive;
+    int filter_sample_step = default_filter_sample_step;
+    pixel_format format = pixel_format::rgba;
+    image_format output_format = image_format::png;
+    bool mmap = false;
+    bool distance_field = false;
+    distance_field_type field_type = distance_field_type::sdf;
+    float field_range = 4.0F;
+    std::vector<FT_ULong> atlas_chars;
+    int cell_size = 64;
+    std::string serve_socket;
+    std::string connect_socket;
+    float size = 64.0F;
+    long batch_window_us = 2000;
+    std::vector<FT_ULong> batch_chars;
+    std::array<unsigned, pipeline_stage_count> pipeline_workers{ 1, 1, 0, 1 };
+    std::size_t queue_capacity = 16;
+    std::string metrics_path;
+    std::string trace_path;
+    std::vector<FT_ULong> compare_chars;
+    std::vector<int> compare_sizes{ std::begin(default_benchmark_sizes), std::end(default_benchmark_sizes) };
+    int repeats = 3;
+    std::vector<FT_ULong> quality_chars;
+    int reference_samples = default_reference_samples;
+    std::string scaling_path;
+    std::vector<int> curve_counts{ 16, 64, 256, 1024, 4096 };
+    synthetic_params shape;
+};
+
+// Writes the collected metrics and trace when `main` returns, whichever path it returns
+// through. By then every worker thread has been joined.
+class exit_reports
+{
+public:
+    explicit exit_reports(options const& opts)
+        : m_metrics_path{ opts.metrics_path }
+        , m_trace_path{ opts.trace_path }
+    {
+        enable_metrics(!m_metrics_path.empty());
+        enable_tracing(!m_trace_path.empty());
+        set_trace_thread_name("main");
+    }
+
+    exit_reports(exit_reports const&) = delete;
+    exit_reports(exit_reports&&) = delete;
+
+    ~exit_reports()
+    {
+        if(!m_metrics_path.empty() && !write_metrics_json(m_metrics_path.c_str())) {
+            spdlog::error("Could not write metrics to {}", m_metrics_path);
+        }
+        if(!m_trace_path.empty() && !write_trace_json(m_trace_path.c_str())) {
+            spdlog::error("Could not write trace to {}", m_trace_path);
+        }
+    }
+
+    auto operator=(exit_reports const&) -> exit_reports& = delete;
+    auto operator=(exit_reports&&) -> exit_reports& = delete;
+
+private:
+    std::string m_metrics_path;
+    std::string m_trace_path;
+};
 
-template<typename T>
-auto clamp(T const x, T const a, T const b) -> T
+[[nodiscard]] auto parse_char_range(std::string const& value, std::vector<FT_ULong>& chars) -> bool
 {
-    return std::min(std::max(x, a), b);
+    char* end = nullptr;
+    auto const first = std::strtoul(value.c_str(), &end, 0);
+    auto last = first;
+
+    if(*end == '-') {
+        last = std::strtoul(end + 1, &end, 0);
+    }
+    if(*end != '\0' || last < first) {
+        return false;
+    }
+
+    chars.clear();
+    for(auto c = first; c <= last; ++c) {
+        chars.push_back(c);
+    }
+    return true;
 }
 
-struct point
+[[nodiscard]] auto parse_options(int const argc, char** argv, options& opts) -> bool
 {
-    float x;
-    float y;
-};
+    // A preset fills in every deflate setting, but an explicit --compression-level wins
+    // wherever it appears on the command line.
+    std::optional<compression_preset> preset;
+    std::optional<int> compression_level;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
 
-struct curve
+        if(arg == "--mmap") {
+            opts.mmap = true;
+            continue;
+        }
+
+        if(i + 1 >= argc) {
+            spdlog::error("Missing value for option {}", arg);
+            return false;
+        }
+
+        std::string const value = argv[++i];
+        char* end = nullptr;
+
+        if(arg == "--font") {
+            opts.font_paths.push_back(value);
+        }
+        else if(arg == "--char") {
+            opts.char_code = std::strtoul(value.c_str(), &end, 0);
+        }
+        else if(arg == "--output") {
+            opts.output_path = value;
+        }
+        else if(arg == "--scale") {
+            opts.scale = std::strtof(value.c_str(), &end);
+        }
+        else if(arg == "--band-height") {
+            opts.band_height = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--compression-level") {
+            compression_level = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--preset") {
+            preset.emplace();
+            if(!parse_compression_preset(value, *preset)) {
+                spdlog::error("Unknown compression preset {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--filter") {
+            if(!parse_png_filter_mode(value, opts.filter)) {
+                spdlog::error("Unknown PNG filter mode {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--filter-sample-step") {
+            opts.filter_sample_step = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--format") {
+            if(value == "rgba") {
+                opts.format = pixel_format::rgba;
+            }
+            else if(value == "coverage") {
+                opts.format = pixel_format::coverage;
+            }
+            else {
+                spdlog::error("Unknown pixel format {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--output-format") {
+            if(!parse_image_format(value, opts.output_format)) {
+                spdlog::error("Unknown output format {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--distance-field") {
+            opts.distance_field = true;
+            if(!parse_distance_field_type(value, opts.field_type)) {
+                spdlog::error("Unknown distance field type {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--range") {
+            opts.field_range = std::strtof(value.c_str(), &end);
+        }
+        else if(arg == "--atlas") {
+            if(!parse_char_range(value, opts.atlas_chars)) {
+                spdlog::error("Invalid character range {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--cell-size") {
+            opts.cell_size = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--serve") {
+            opts.serve_socket = value;
+        }
+        else if(arg == "--connect") {
+            opts.connect_socket = value;
+        }
+        else if(arg == "--size") {
+            opts.size = std::strtof(value.c_str(), &end);
+        }
+        else if(arg == "--batch-window-us") {
+            opts.batch_window_us = std::strtol(value.c_str(), &end, 10);
+        }
+        else if(arg == "--batch") {
+            if(!parse_char_range(value, opts.batch_chars)) {
+                spdlog::error("Invalid character range {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--pipeline-workers") {
+            if(!parse_pipeline_workers(value, opts.pipeline_workers)) {
+                spdlog::error("Invalid worker counts {}, expected load,preprocess,raster,encode", value);
+                return false;
+            }
+        }
+        else if(arg == "--queue-capacity") {
+            opts.queue_capacity = std::strtoul(value.c_str(), &end, 10);
+        }
+        else if(arg == "--compare-freetype") {
+            if(!parse_char_range(value, opts.compare_chars)) {
+                spdlog::error("Invalid character range {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--quality") {
+            if(!parse_char_range(value, opts.quality_chars)) {
+                spdlog::error("Invalid character range {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--samples") {
+            opts.reference_samples = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--sizes") {
+            if(!parse_size_list(value, opts.compare_sizes)) {
+                spdlog::error("Invalid size list {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--repeat") {
+            opts.repeats = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--scaling") {
+            opts.scaling_path = value;
+        }
+        else if(arg == "--curve-counts") {
+            if(!parse_size_list(value, opts.curve_counts)) {
+                spdlog::error("Invalid curve count list {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--seed") {
+            opts.shape.seed = std::strtoull(value.c_str(), &end, 10);
+        }
+        else if(arg == "--contours") {
+            opts.shape.contours = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--nesting") {
+            opts.shape.nesting = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+        }
+        else if(arg == "--self-intersection") {
+            opts.shape.self_intersection = std::strtof(value.c_str(), &end);
+        }
+        else if(arg == "--thin-fraction") {
+            opts.shape.thin_fraction = std::strtof(value.c_str(), &end);
+        }
+        else if(arg == "--distribution") {
+            if(!parse_point_distribution(value, opts.shape.distribution)) {
+                spdlog::error("Unknown point distribution {}", value);
+                return false;
+            }
+        }
+        else if(arg == "--metrics") {
+            opts.metrics_path = value;
+        }
+        else if(arg == "--trace") {
+            opts.trace_path = value;
+        }
+        else if(arg == "--threads") {
+            opts.deflate.threads = static_cast<unsigned>(std::strtoul(value.c_str(), &end, 10));
+        }
+        else {
+            spdlog::error("Unknown option {}", arg);
+            return false;
+        }
+
+        if(end != nullptr && *end != '\0') {
+            spdlog::error("Invalid value '{}' for option {}", value, arg);
+            return false;
+        }
+    }
+
+    if(opts.font_paths.empty()) {
+        opts.font_paths.emplace_back("./JFWilwod.ttf");
+    }
+
+    if(preset) {
+        auto const threads = opts.deflate.threads;
+        opts.deflate = make_deflate_settings(*preset);
+        opts.deflate.threads = threads;
+    }
+    if(compression_level) {
+        opts.deflate.level = *compression_level;
+    }
+
+    if(opts.scale <= 0.0F) {
+        spdlog::error("--scale must be positive");
+        return false;
+    }
+    if(opts.size <= 0.0F) {
+        spdlog::error("--size must be positive");
+        return false;
+    }
+    if(opts.batch_window_us < 0) {
+        spdlog::error("--batch-window-us must not be negative");
+        return false;
+    }
+    if(opts.band_height < 0) {
+        spdlog::error("--band-height must not be negative");
+        return false;
+    }
+    if(opts.deflate.level < 0 || opts.deflate.level > 9) {
+        spdlog::error("--compression-level must be between 0 and 9");
+        return false;
+    }
+    if(opts.filter_sample_step <= 0) {
+        spdlog::error("--filter-sample-step must be positive");
+        return false;
+    }
+    if(opts.queue_capacity == 0) {
+        spdlog::error("--queue-capacity must be positive");
+        return false;
+    }
+    if(opts.repeats <= 0) {
+        spdlog::error("--repeat must be positive");
+        return false;
+    }
+    if(opts.reference_samples <= 0) {
+        spdlog::error("--samples must be positive");
+        return false;
+    }
+    if(opts.field_range <= 0.0F) {
+        spdlog::error("--range must be positive");
+        return false;
+    }
+    // Only an atlas packs fields into cells; a single glyph's field can use any range.
+    if(!opts.atlas_chars.empty() && opts.cell_size <= 2 * opts.field_range) {
+        spdlog::error("--cell-size must exceed 2 x --range");
+        return false;
+    }
+    if(opts.shape.contours <= 0) {
+        spdlog::error("--contours must be positive");
+        return false;
+    }
+    if(opts.shape.nesting <= 0) {
+        spdlog::error("--nesting must be positive");
+        return false;
+    }
+    if(opts.shape.self_intersection < 0.0F) {
+        spdlog::error("--self-intersection must not be negative");
+        return false;
+    }
+    if(opts.shape.thin_fraction < 0.0F || opts.shape.thin_fraction > 1.0F) {
+        spdlog::error("--thin-fraction must be between 0 and 1");
+        return false;
+    }
+
+    return true;
+}
+
+// No output format holds an empty image, and a size from a bad outline must not reach an allocation
+// or a file mapping.
+[[nodiscard]] auto check_image_size(int const width, int const height) -> bool
 {
-    point p1;
-    point p2;
-    point p3;
-};
+    if(width <= 0 || height <= 0) {
+        spdlog::error("Nothing to render: the glyph is {}x{} pixels!", width, height);
+        return false;
+    }
+    return true;
+}
 
-[[nodiscard]] auto curve_str(curve const& c) -> std::string
+[[nodiscard]] auto write_png_streaming(options const& opts,
+                                       std::vector<curve> const& curves,
+                                       raster_params const& params) -> bool
 {
-    return fmt::format("({}, {}), ({}, {}), ({}, {})", c.p1.x, c.p1.y, c.p2.x, c.p2.y, c.p3.x, c.p3.y);
+    png_stream stream;
+
+    int const channels = channel_count(params.format);
+
+    if(!stream.open(opts.output_path.c_str(), params.width, params.height, channels, opts.deflate.level)) {
+        return false;
+    }
+
+    stream.set_filter_mode(opts.filter, opts.filter_sample_step);
+
+    auto const band_height = std::min(opts.band_height, params.height);
+    auto const stride = static_cast<std::size_t>(params.width) * channels;
+
+    std::vector<std::uint8_t> band;
+    band.resize(stride * band_height);
+
+    for(int row = 0; row < params.height; row += band_height) {
+        auto const rows = std::min(band_height, params.height - row);
+
+        render_rows(curves, params, row, rows, band.data(), stride);
+
+        if(!stream.write_rows(band.data(), rows, stride)) {
+            return false;
+        }
+    }
+
+    return stream.close();
 }
 
-auto eval_curve(float const y1, float const y2, float const y3, float const t) -> float
+[[nodiscard]] auto write_uncompressed_streaming(options const& opts,
+                                                std::vector<curve> const& curves,
+                                                raster_params const& params) -> bool
 {
-    float const it = 1.0F - t;
+    int const channels = channel_count(params.format);
+    auto const header = netpbm_header(opts.output_format, params.width, params.height, channels);
+
+    std::FILE* file = std::fopen(opts.output_path.c_str(), "wb");
+
+    if(file == nullptr) {
+        spdlog::error("Could not open {} for writing!", opts.output_path);
+        return false;
+    }
+
+    auto const band_height = std::min(opts.band_height, params.height);
+    auto const stride = static_cast<std::size_t>(params.width) * channels;
+
+    std::vector<std::uint8_t> band;
+    band.resize(stride * band_height);
+
+    bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+
+    for(int row = 0; ok && row < params.height; row += band_height) {
+        auto const rows = std::min(band_height, params.height - row);
+
+        render_rows(curves, params, row, rows, band.data(), stride);
+
+        ok = std::fwrite(band.data(), stride, rows, file) == static_cast<std::size_t>(rows);
+    }
 
-    return it * it * y1 + 2.0F * t * it * y2 + t * t * y3;
+    return (std::fclose(file) == 0) && ok;
 }
 
-int width = 800;
-int height = 800;
-int num_channels = 4;
+[[nodiscard]] auto write_streaming(options const& opts, std::vector<curve> const& curves, raster_params const& params)
+    -> bool
+{
+    if(!check_image_size(params.width, params.height)) {
+        return false;
+    }
+    if(opts.output_format == image_format::png) {
+        return write_png_streaming(opts, curves, params);
+    }
+    if(is_uncompressed_layout(opts.output_format, params.format)) {
+        return write_uncompressed_streaming(opts, curves, params);
+    }
+
+    spdlog::error("Banded output needs png, raw, pam, or pgm with --format coverage!");
+    return false;
+}
 
-enum class orientation
+// The pixel rows are rendered directly into the mapped output file, right after its header.
+[[nodiscard]] auto write_mapped(options const& opts, std::vector<curve> const& curves, raster_params const& params)
+    -> bool
 {
-    horizontal,
-    vertical
-};
+    if(!is_uncompressed_layout(opts.output_format, params.format)) {
+        spdlog::error("--mmap needs raw, pam, or pgm with --format coverage!");
+        return false;
+    }
+    if(!check_image_size(params.width, params.height)) {
+        return false;
+    }
+
+    int const channels = channel_count(params.format);
+    auto const header = netpbm_header(opts.output_format, params.width, params.height, channels);
+    auto const stride = static_cast<std::size_t>(params.width) * channels;
+
+    mapped_file file;
+
+    if(!file.open(opts.output_path.c_str(), header.size() + stride * params.height)) {
+        return false;
+    }
+
+    std::copy(header.begin(), header.end(), file.data());
 
-auto trace_ray(std::vector<curve> const& curves,
-               float const fx,
-               float const fy,
-               float const ppem,
-               orientation const orient = orientation::horizontal) -> float
+    render_rows(curves, params, 0, params.height, file.data() + header.size(), stride);
+
+    return file.close();
+}
+
+[[nodiscard]] auto write_distance_field(options const& opts, glyph_outline const& outline) -> bool
 {
-    float coverage = 0.0F;
+    auto params = make_distance_field_params(outline, opts.scale, opts.field_type, opts.field_range);
+    params.threads = opts.deflate.threads;
 
-    for(auto const& crv : curves) {
-        auto x1 = crv.p1.x - fx;
-        auto x2 = crv.p2.x - fx;
-        auto x3 = crv.p3.x - fx;
+    if(!check_image_size(params.width, params.height)) {
+        return false;
+    }
 
-        auto y1 = crv.p1.y - fy;
-        auto y2 = crv.p2.y - fy;
-        auto y3 = crv.p3.y - fy;
+    int const channels = channel_count(params.type);
+    auto const stride = static_cast<std::size_t>(params.width) * channels;
 
-        if(orient == orientation::vertical) {
-            x1 = crv.p1.y - fy;
-            x2 = crv.p2.y - fy;
-            x3 = crv.p3.y - fy;
+    std::vector<std::uint8_t> pixels(stride * params.height);
+    std::vector<std::uint8_t> encoded;
 
-            y1 = crv.p1.x - fx;
-            y2 = crv.p2.x - fx;
-            y3 = crv.p3.x - fx;
-        }
+    render_distance_field(outline.curves, params, pixels.data(), stride);
 
-        auto const a = y1 - 2 * y2 + y3;
-        auto const b = y1 - y2;
-        auto const c = y1;
+    image_view const image{ pixels.data(), params.width, params.height, channels, stride };
 
-        float t1 = 0.0F;
-        float t2 = 0.0F;
+    return encode_image(image, opts.output_format, encoded) && write_file(opts.output_path.c_str(), encoded);
+}
 
-        if(std::abs(a) < 0.0001F) {
-            t1 = t2 = c / (2.0F * b);
-        }
-        else {
-            float const root = std::sqrt(std::max(b * b - a * c, 0.0F));
-            t1 = (b - root) / a;
-            t2 = (b + root) / a;
+// Bakes every character of `opts.atlas_chars` into a grid of `cell_size` squares. All glyphs
+// share one scale and one origin (the font's bounding box corner), so a cell maps back to font
+// units the same way for every glyph; the mapping is written next to the image as JSON.
+[[nodiscard]] auto write_distance_field_atlas(options const& opts, FT_Face face) -> bool
+{
+    float const pad = opts.field_range;
+    auto const extent = std::max(face->bbox.xMax - face->bbox.xMin, face->bbox.yMax - face->bbox.yMin);
+    auto const columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(opts.atlas_chars.size()))));
+    auto const rows = static_cast<int>((opts.atlas_chars.size() + columns - 1) / columns);
+
+    distance_field_params params;
+    params.type = opts.field_type;
+    params.range = opts.field_range;
+    params.threads = opts.deflate.threads;
+    params.width = opts.cell_size;
+    params.height = opts.cell_size;
+    params.scale = (opts.cell_size - 2.0F * pad) / static_cast<float>(extent);
+    params.min_x = face->bbox.xMin - pad / params.scale;
+    params.min_y = face->bbox.yMin - pad / params.scale;
+
+    int const channels = channel_count(params.type);
+    int const width = columns * opts.cell_size;
+    int const height = rows * opts.cell_size;
+    auto const stride = static_cast<std::size_t>(width) * channels;
+
+    std::vector<std::uint8_t> pixels(stride * height);
+    std::string json = fmt::format("{{\"cell_size\": {}, \"columns\": {}, \"scale\": {}, \"range\": {}, "
+                                   "\"origin\": [{}, {}], \"glyphs\": [",
+                                   opts.cell_size,
+                                   columns,
+                                   params.scale,
+                                   params.range,
+                                   params.min_x,
+                                   params.min_y);
+
+    glyph_outline outline;
+
+    for(std::size_t i = 0; i < opts.atlas_chars.size(); ++i) {
+        auto const c = opts.atlas_chars[i];
+        trace_span const span{ "glyph", "atlas", "char", static_cast<std::int64_t>(c) };
+
+        if(!load_glyph_outline(face, c, outline)) {
+            return false;
         }
 
-        auto const num = ((y1 > 0.0F) ? 2 : 0) + ((y2 > 0.0F) ? 4 : 0) + ((y3 > 0.0F) ? 8 : 0);
-        auto const sh = 0x2E74 >> num;
+        auto const cx = static_cast<int>(i % columns) * opts.cell_size;
+        auto const cy = static_cast<int>(i / columns) * opts.cell_size;
 
-        if((sh & 1) != 0) {
-            float const r1 = eval_curve(x1, x2, x3, t1);
-            coverage += clamp(r1 * ppem + 0.5F, 0.0F, 1.0F);
-        }
-        if((sh & 2) != 0) {
-            float const r2 = eval_curve(x1, x2, x3, t2);
-            coverage -= clamp(r2 * ppem + 0.5F, 0.0F, 1.0F);
-        }
+        render_distance_field(
+            outline.curves, params, pixels.data() + cy * stride + static_cast<std::size_t>(cx) * channels, stride);
+
+        json += fmt::format("{}{{\"char\": {}, \"cell\": {}}}", i == 0 ? "" : ", ", c, i);
     }
 
-    return coverage;
+    json += "]}\n";
+
+    std::vector<std::uint8_t> encoded;
+    image_view const image{ pixels.data(), width, height, channels, stride };
+
+    return encode_image(image, opts.output_format, encoded) && write_file(opts.output_path.c_str(), encoded) &&
+           write_file((opts.output_path + ".json").c_str(), std::vector<std::uint8_t>(json.begin(), json.end()));
 }
 
-std::function<int(FT_Vector const*, void*)> g_move_to;
-std::function<int(FT_Vector const*, void*)> g_line_to;
-std::function<int(FT_Vector const*, FT_Vector const*, void*)> g_quadratic_to;
-std::function<int(FT_Vector const*, FT_Vector const*, FT_Vector const*, void*)> g_cubic_to;
+[[nodiscard]] auto render_batch(options const& opts) -> bool
+{
+    pipeline_options batch;
+    batch.font_path = opts.font_paths.front();
+    batch.chars = opts.batch_chars;
+    batch.output_pattern = opts.output_path;
+    batch.scale = opts.scale;
+    batch.format = opts.format;
+    batch.output_format = opts.output_format;
+    batch.workers = opts.pipeline_workers;
+    batch.queue_capacity = opts.queue_capacity;
+
+    pipeline_stats stats;
+    bool const ok = run_pipeline(batch, stats);
+
+    log_pipeline_stats(stats);
+    return ok;
+}
 
-auto main() noexcept -> int
+[[nodiscard]] auto serve(options const& opts) -> bool
 {
-    FT_Library library;
-    FT_Face face;
+    server_options server;
+    server.socket_path = opts.serve_socket;
+    server.font_paths = opts.font_paths;
+    server.threads = opts.deflate.threads;
+    server.batch_window = std::chrono::microseconds{ opts.batch_window_us };
+    server.field_range = opts.field_range;
+
+    return run_server(server);
+}
 
-    auto error = FT_Init_FreeType(&library);
+// Renders `opts.char_code` of font #0 through a running server and writes it like a local render.
+[[nodiscard]] auto render_remote(options const& opts) -> bool
+{
+    request_header header;
+    header.flags = request_flag_char_codes;
+    header.size = opts.size;
 
-    if(error) {
-        spdlog::error("Couldn't initialize Freetype!");
+    bool const server_png = !opts.distance_field && opts.output_format == image_format::png;
+
+    if(opts.distance_field) {
+        header.format = static_cast<std::uint32_t>(
+            opts.field_type == distance_field_type::sdf ? render_format::sdf : render_format::msdf);
+    }
+    else if(opts.format == pixel_format::coverage) {
+        header.format =
+            static_cast<std::uint32_t>(server_png ? render_format::png_coverage : render_format::coverage);
+    }
+    else {
+        header.format = static_cast<std::uint32_t>(server_png ? render_format::png_rgba : render_format::rgba);
     }
 
-    error = FT_New_Face(library, "./JFWilwod.ttf", 0, &face);
+    std::vector<glyph_result> results;
 
-    if(error == FT_Err_Unknown_File_Format) {
-        spdlog::error("Font file not recognized by Freetype!");
-    }
-    else if(error) {
-        spdlog::error("Font file could not be read :(");
+    if(!request_glyphs(opts.connect_socket, header, { static_cast<std::uint32_t>(opts.char_code) }, results) ||
+       results.size() != 1 || results[0].header.status != static_cast<std::uint32_t>(render_status::ok)) {
+        spdlog::error("Remote render of glyph #{} failed!", opts.char_code);
+        return false;
     }
 
-    auto const em_units = face->units_per_EM;
+    auto const& glyph = results[0];
 
-    spdlog::info("num_glyphs: {}", face->num_glyphs);
-    spdlog::info("units_per_em: {}", em_units);
+    if(server_png) {
+        return write_file(opts.output_path.c_str(), glyph.data);
+    }
 
-    FT_ULong const index = 87;
+    image_view const image{ glyph.data.data(),
+                            glyph.header.width,
+                            glyph.header.height,
+                            static_cast<int>(glyph.header.channels),
+                            static_cast<std::size_t>(glyph.header.width) * glyph.header.channels };
+    std::vector<std::uint8_t> encoded;
 
-    spdlog::info("Outline data for glyph #{}", index);
+    return encode_image(image, opts.output_format, encoded) && write_file(opts.output_path.c_str(), encoded);
+}
 
-    FT_UInt glyph_index = FT_Get_Char_Index(face, index);
-    if(FT_Load_Glyph(face, glyph_index, FT_LOAD_NO_SCALE)) {
-        spdlog::error("Could not load glyph #{}", index);
+auto main(int argc, char** argv) -> int
+{
+    options opts;
+
+    if(!parse_options(argc, argv, opts)) {
+        spdlog::error("Usage: {} [--font path] [--char code] [--output path] [--scale factor] [--band-height rows] "
+                      "[--preset fastest|fast|balanced|smallest] [--compression-level 0-9] [--threads n] "
+                      "[--filter adaptive|sampled|none|sub|up|average|paeth] [--filter-sample-step n] "
+                      "[--format rgba|coverage] [--output-format png|raw|pgm|ppm|pam|bmp|tga] [--mmap] "
+                      "[--distance-field sdf|msdf] [--range px] [--atlas first-last] [--cell-size px] "
+                      "[--serve socket] [--connect socket] [--size ppem] [--batch-window-us us] "
+                      "[--batch first-last] [--pipeline-workers l,p,r,e] [--queue-capacity n] "
+                      "[--metrics path.json] [--trace path.json] "
+                      "[--compare-freetype first-last] [--sizes 8,16,...] [--repeat n] "
+                      "[--quality first-last] [--samples n] "
+                      "[--scaling path.csv] [--curve-counts 16,64,...] [--seed n] [--contours n] [--nesting n] "
+                      "[--self-intersection steps] [--thin-fraction 0-1] [--distribution uniform|clustered]",
+                      argv[0]);
+        return 1;
     }
 
-    FT_Pos glyph_width = face->glyph->metrics.width;
-    FT_Pos glyph_height = face->glyph->metrics.height;
+    // Builds with a lower SPDLOG_ACTIVE_LEVEL (see BEZIER_LOG_LEVEL) also want those messages printed.
+    spdlog::set_level(static_cast<spdlog::level::level_enum>(SPDLOG_ACTIVE_LEVEL));
 
-    spdlog::info("Glyph metrics: w={}, h={}", glyph_width, glyph_height);
+    exit_reports const reports{ opts };
 
-    std::vector<curve> curves;
+    set_deflate_settings(opts.deflate);
+    set_png_filter_mode(opts.filter, opts.filter_sample_step);
 
-    point prev{ 0.0F, 0.0F };
-    float min_x = 16384.0F;
-    float min_y = 16384.0F;
-    float max_x = -16384.0F;
-    float max_y = -16384.0F;
+    if(!opts.serve_socket.empty()) {
+        return serve(opts) ? 0 : 1;
+    }
+    if(!opts.connect_socket.empty()) {
+        return render_remote(opts) ? 0 : 1;
+    }
+    if(!opts.batch_chars.empty()) {
+        return render_batch(opts) ? 0 : 1;
+    }
+    if(!opts.scaling_path.empty()) {
+        std::vector<scaling_sample> samples;
+        bool const ok = run_scaling_study(opts.shape, opts.curve_counts, opts.compare_sizes, opts.repeats, samples);
+        return ok && write_scaling_csv(opts.scaling_path.c_str(), samples) ? 0 : 1;
+    }
 
-    g_move_to = [&](FT_Vector const* to, void*) -> int {
-        spdlog::info("Move to: ({}, {})", to->x, to->y);
-        prev = point{ static_cast<float>(to->x), static_cast<float>(to->y) };
-        min_x = std::min(min_x, prev.x);
-        min_y = std::min(min_y, prev.y);
-        max_x = std::max(max_x, prev.x);
-        max_y = std::max(max_y, prev.y);
-        return 0;
-    };
-    g_line_to = [&](FT_Vector const* to, void*) -> int {
-        spdlog::info("Line to: ({}, {})", to->x, to->y);
-        point const c{ static_cast<float>(to->x), static_cast<float>(to->y) };
-        curves.push_back(curve{ prev, point{ (prev.x + c.x) / 2.0F, (prev.y + c.y) / 2.0F }, c });
-        prev = c;
-        min_x = std::min(min_x, prev.x);
-        min_y = std::min(min_y, prev.y);
-        max_x = std::max(max_x, prev.x);
-        max_y = std::max(max_y, prev.y);
-        return 0;
-    };
-    g_quadratic_to = [&](FT_Vector const* control, FT_Vector const* to, void*) -> int {
-        spdlog::info("Quadratic to ({}, {}), ({}, {})", control->x, control->y, to->x, to->y);
-        curves.push_back(curve{ prev,
-                                point{ static_cast<float>(control->x), static_cast<float>(control->y) },
-                                point{ static_cast<float>(to->x), static_cast<float>(to->y) } });
-        prev = point{ static_cast<float>(to->x), static_cast<float>(to->y) };
-        min_x = std::min({ min_x, static_cast<float>(to->x), static_cast<float>(control->x) });
-        min_y = std::min({ min_y, static_cast<float>(to->y), static_cast<float>(control->y) });
-        max_x = std::max({ max_x, static_cast<float>(to->x), static_cast<float>(control->x) });
-        max_y = std::max({ max_y, static_cast<float>(to->y), static_cast<float>(control->y) });
-        return 0;
-    };
-    g_cubic_to = [&](FT_Vector const* control1, FT_Vector const* control2, FT_Vector const* to, void*) -> int {
-        spdlog::info(
-            "Cubic to ({}, {}), ({}, {}), ({}, {})", control1->x, control1->y, control2->x, control2->y, to->x, to->y);
-        return 0;
-    };
+    FT_Library library;
+    FT_Face face;
 
-    FT_Outline_Funcs f;
+    FT_Error init_error = 0;
+    FT_Error error = 0;
 
-    f.delta = 0;
-    f.shift = 0;
+    {
+        phase_timer const timer{ phase::font_open };
 
-    f.move_to = [](FT_Vector const* to, void*) -> int { return g_move_to(to, nullptr); };
-    f.line_to = [](FT_Vector const* to, void*) -> int { return g_line_to(to, nullptr); };
-    f.conic_to = [](FT_Vector const* control, FT_Vector const* to, void*) -> int {
-        return g_quadratic_to(control, to, nullptr);
-    };
-    f.cubic_to = [](FT_Vector const* c1, FT_Vector const* c2, FT_Vector const* to, void*) -> int {
-        return g_cubic_to(c1, c2, to, nullptr);
-    };
+        init_error = FT_Init_FreeType(&library);
+        error = init_error ? init_error : FT_New_Face(library, opts.font_paths.front().c_str(), 0, &face);
+    }
 
-    error = FT_Outline_Decompose(&face->glyph->outline, &f, nullptr);
+    if(init_error) {
+        spdlog::error("Couldn't initialize Freetype!");
+        return 1;
+    }
 
+    if(error == FT_Err_Unknown_File_Format) {
+        spdlog::error("Font file not recognized by Freetype!");
+        return 1;
+    }
     if(error) {
-        spdlog::error("Could not decompose outlines!");
+        spdlog::error("Font file could not be read :(");
+        return 1;
     }
 
-    for(auto const& c : curves) {
-        spdlog::info("Draw quadratic: {}", curve_str(c));
+    auto const em_units = face->units_per_EM;
+
+    spdlog::info("num_glyphs: {}", face->num_glyphs);
+    spdlog::info("units_per_em: {}", em_units);
+
+    if(!opts.compare_chars.empty()) {
+        std::vector<size_comparison> results;
+        if(!compare_with_freetype(face, opts.compare_chars, opts.compare_sizes, opts.repeats, results)) {
+            return 1;
+        }
+        log_size_comparison(results);
+        return 0;
     }
 
-    spdlog::info("MinX={}, MinY={}", min_x, min_y);
-    spdlog::info("MaxX={}, MaxY={}", max_x, max_y);
+    if(!opts.quality_chars.empty()) {
+        std::vector<quality_result> results;
+        if(!measure_quality(
+               face, opts.quality_chars, opts.compare_sizes, opts.reference_samples, opts.repeats, results)) {
+            return 1;
+        }
+        log_quality(results);
+        return 0;
+    }
 
-    width = static_cast<int>(max_x) - static_cast<int>(min_x);
-    height = static_cast<int>(max_y) - static_cast<int>(min_y);
+    if(opts.distance_field && !opts.atlas_chars.empty()) {
+        return write_distance_field_atlas(opts, face) ? 0 : 1;
+    }
 
-    spdlog::info("w={}, h={}", width, height);
+    trace_span const span{ "glyph", "render", "char", static_cast<std::int64_t>(opts.char_code) };
+    glyph_outline outline;
 
-    std::vector<std::uint8_t> pixels;
-    pixels.resize(width * height * num_channels);
+    if(!load_glyph_outline(face, opts.char_code, outline)) {
+        return 1;
+    }
 
-    for(int y = 0; y < height; ++y) {
-        for(int x = 0; x < width; ++x) {
-            auto const fx = float(x) + min_x;
-            auto const fy = float(y) + min_y;
+    if(opts.distance_field) {
+        return write_distance_field(opts, outline) ? 0 : 1;
+    }
 
-            float const ppem_h = width * 1.0F;
-            float const ppem_v = height * 1.0F;
+    auto const params = make_raster_params(outline, opts.scale, opts.format);
 
-            float const coverage_h = std::min(std::abs(trace_ray(curves, fx, fy, ppem_h)), 1.0F);
-            float const coverage_v = std::min(std::abs(trace_ray(curves, fx, fy, ppem_v, orientation::vertical)), 1.0F);
-            float const avg_coverage = (coverage_h + coverage_v) / 2.0F;
+    spdlog::info("w={}, h={}", params.width, params.height);
 
-            auto const max_height = (height - 1) * width * num_channels;
+    if(opts.mmap) {
+        return write_mapped(opts, outline.curves, params) ? 0 : 1;
+    }
 
-            pixels[max_height - y * width * num_channels + x * num_channels] = 255 * avg_coverage;
-            pixels[max_height - y * width * num_channels + x * num_channels + 1] = 128 * avg_coverage;
-            pixels[max_height - y * width * num_channels + x * num_channels + 2] = 64 * avg_coverage;
-            pixels[max_height - y * width * num_channels + x * num_channels + 3] = 255;
-        }
+    if(opts.band_height > 0) {
+        return write_streaming(opts, outline.curves, params) ? 0 : 1;
+    }
+
+    if(!check_image_size(params.width, params.height)) {
+        return 1;
+    }
+
+    std::vector<std::uint8_t> pixels;
+    std::vector<std::uint8_t> encoded;
+
+    auto const image = render_image(outline.curves, params, pixels);
+
+    if(!encode_image(image, opts.output_format, encoded) || !write_file(opts.output_path.c_str(), encoded)) {
+        return 1;
     }
 
-    stbi_write_png("img.png", width, height, num_channels, pixels.data(), width * num_channels);
+    return 0;
 }
@@ -0,0 +1,142 @@
+#include "metrics.hpp"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "encode.hpp"
+
+namespace detail {
+bool g_metrics_enabled = false;
+} // namespace detail
+
+namespace {
+
+std::array<std::atomic<std::uint64_t>, phase_count> g_phase_ns{};
+std::array<std::atomic<std::uint64_t>, phase_count> g_phase_calls{};
+std::array<std::atomic<std::uint64_t>, counter_count> g_counters{};
+
+} // namespace
+
+auto enable_metrics(bool const enabled) -> void
+{
+    detail::g_metrics_enabled = enabled;
+}
+
+auto reset_metrics() -> void
+{
+    for(std::size_t i = 0; i < phase_count; ++i) {
+        g_phase_ns[i].store(0, std::memory_order_relaxed);
+        g_phase_calls[i].store(0, std::memory_order_relaxed);
+    }
+    for(auto& c : g_counters) {
+        c.store(0, std::memory_order_relaxed);
+    }
+}
+
+auto add_phase_time(phase const p, std::chrono::nanoseconds const elapsed) -> void
+{
+    auto const i = static_cast<std::size_t>(p);
+    g_phase_ns[i].fetch_add(static_cast<std::uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    g_phase_calls[i].fetch_add(1, std::memory_order_relaxed);
+}
+
+auto add_count(counter const c, std::uint64_t const n) -> void
+{
+    g_counters[static_cast<std::size_t>(c)].fetch_add(n, std::memory_order_relaxed);
+}
+
+auto phase_timer::finish(phase const p, std::int64_t const start_ns) -> void
+{
+    auto const end_ns = detail::trace_now();
+
+    if(metrics_enabled()) {
+        add_phase_time(p, std::chrono::nanoseconds{ end_ns - start_ns });
+    }
+    if(tracing_enabled()) {
+        detail::record_span(phase_name(p), "phase", start_ns, end_ns, nullptr, 0);
+    }
+}
+
+auto phase_seconds(phase const p) -> double
+{
+    return static_cast<double>(g_phase_ns[static_cast<std::size_t>(p)].load(std::memory_order_relaxed)) * 1e-9;
+}
+
+auto phase_calls(phase const p) -> std::uint64_t
+{
+    return g_phase_calls[static_cast<std::size_t>(p)].load(std::memory_order_relaxed);
+}
+
+auto count(counter const c) -> std::uint64_t
+{
+    return g_counters[static_cast<std::size_t>(c)].load(std::memory_order_relaxed);
+}
+
+auto phase_name(phase const p) -> char const*
+{
+    switch(p) {
+    case phase::font_open:
+        return "font_open";
+    case phase::glyph_load:
+        return "glyph_load";
+    case phase::decompose:
+        return "decompose";
+    case phase::preprocess:
+        return "preprocess";
+    case phase::raster:
+        return "raster";
+    case phase::encode:
+        return "encode";
+    case phase::write:
+        return "write";
+    }
+    return "unknown";
+}
+
+auto counter_name(counter const c) -> char const*
+{
+    switch(c) {
+    case counter::curves_visited:
+        return "curves_visited";
+    case counter::roots_solved:
+        return "roots_solved";
+    case counter::pixels_shaded:
+        return "pixels_shaded";
+    case counter::early_exits:
+        return "early_exits";
+    }
+    return "unknown";
+}
+
+auto metrics_json() -> std::string
+{
+    std::string json = "{\"phases\": {";
+
+    for(std::size_t i = 0; i < phase_count; ++i) {
+        auto const p = static_cast<phase>(i);
+        json += fmt::format("{}\"{}\": {{\"calls\": {}, \"seconds\": {:.9f}}}",
+                            i == 0 ? "" : ", ",
+                            phase_name(p),
+                            phase_calls(p),
+                            phase_seconds(p));
+    }
+
+    json += "}, \"counters\": {";
+
+    for(std::size_t i = 0; i < counter_count; ++i) {
+        auto const c = static_cast<counter>(i);
+        json += fmt::format("{}\"{}\": {}", i == 0 ? "" : ", ", counter_name(c), count(c));
+    }
+
+    json += "}}\n";
+    return json;
+}
+
+auto write_metrics_json(char const* filename) -> bool
+{
+    auto const json = metrics_json();
+    return write_file(filename, std::vector<std::uint8_t>(json.begin(), json.end()));
+}
@@ -0,0 +1,95 @@
+#ifndef BEZIER_METRICS_HPP
+#define BEZIER_METRICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "trace.hpp"
+
+// Process-wide phase timers and work counters. Everything is off until `enable_metrics` is
+// called; while off, a timer or counter costs one predictable branch on a global flag. Phase
+// times are summed over all threads, so with parallel phases they can exceed wall time.
+enum class phase
+{
+    font_open,
+    glyph_load,
+    decompose,
+    preprocess,
+    raster,
+    encode,
+    write
+};
+
+constexpr std::size_t phase_count = 7;
+
+enum class counter
+{
+    curves_visited,
+    roots_solved,
+    pixels_shaded,
+    early_exits
+};
+
+constexpr std::size_t counter_count = 4;
+
+namespace detail {
+extern bool g_metrics_enabled;
+} // namespace detail
+
+[[nodiscard]] inline auto metrics_enabled() noexcept -> bool
+{
+    return detail::g_metrics_enabled;
+}
+
+// Not synchronized with running work: call it before any rendering starts.
+auto enable_metrics(bool enabled = true) -> void;
+auto reset_metrics() -> void;
+
+auto add_phase_time(phase p, std::chrono::nanoseconds elapsed) -> void;
+auto add_count(counter c, std::uint64_t n) -> void;
+
+[[nodiscard]] auto phase_seconds(phase p) -> double;
+[[nodiscard]] auto phase_calls(phase p) -> std::uint64_t;
+[[nodiscard]] auto count(counter c) -> std::uint64_t;
+
+[[nodiscard]] auto phase_name(phase p) -> char const*;
+[[nodiscard]] auto counter_name(counter c) -> char const*;
+
+// {"phases": {"raster": {"calls": n, "seconds": s}, ...}, "counters": {"pixels_shaded": n, ...}}
+[[nodiscard]] auto metrics_json() -> std::string;
+[[nodiscard]] auto write_metrics_json(char const* filename) -> bool;
+
+// Adds the time between construction and destruction to `p`, and records it as a span on the
+// trace timeline when tracing is on. Reads no clock while both are off.
+class phase_timer
+{
+public:
+    explicit phase_timer(phase const p) noexcept
+        : m_phase{ p }
+        , m_start{ metrics_enabled() || tracing_enabled() ? detail::trace_now() : -1 }
+    {
+    }
+
+    phase_timer(phase_timer const&) = delete;
+    phase_timer(phase_timer&&) = delete;
+
+    ~phase_timer()
+    {
+        if(m_start >= 0) {
+            finish(m_phase, m_start);
+        }
+    }
+
+    auto operator=(phase_timer const&) -> phase_timer& = delete;
+    auto operator=(phase_timer&&) -> phase_timer& = delete;
+
+private:
+    static auto finish(phase p, std::int64_t start_ns) -> void;
+
+    phase m_phase;
+    std::int64_t m_start;
+};
+
+#endif // BEZIER_METRICS_HPP
@@ -0,0 +1,186 @@
+#include "outline.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include FT_OUTLINE_H
+
+#include "metrics.hpp"
+
+namespace {
+
+struct decompose_state
+{
+    glyph_outline* outline;
+    point prev;
+};
+
+auto extend_bounds(glyph_outline& outline, point const& p) -> void
+{
+    outline.min_x = std::min(outline.min_x, p.x);
+    outline.min_y = std::min(outline.min_y, p.y);
+    outline.max_x = std::max(outline.max_x, p.x);
+    outline.max_y = std::max(outline.max_y, p.y);
+}
+
+auto to_point(FT_Vector const* v) -> point
+{
+    return point{ static_cast<float>(v->x), static_cast<float>(v->y) };
+}
+
+auto move_to(FT_Vector const* to, void* user) -> int
+{
+    auto& state = *static_cast<decompose_state*>(user);
+    SPDLOG_TRACE("Move to: ({}, {})", to->x, to->y);
+    state.prev = to_point(to);
+    extend_bounds(*state.outline, state.prev);
+    return 0;
+}
+
+auto line_to(FT_Vector const* to, void* user) -> int
+{
+    auto& state = *static_cast<decompose_state*>(user);
+    SPDLOG_TRACE("Line to: ({}, {})", to->x, to->y);
+    point const c = to_point(to);
+    state.outline->curves.push_back(
+        curve{ state.prev, point{ (state.prev.x + c.x) / 2.0F, (state.prev.y + c.y) / 2.0F }, c });
+    state.prev = c;
+    extend_bounds(*state.outline, state.prev);
+    return 0;
+}
+
+auto conic_to(FT_Vector const* control, FT_Vector const* to, void* user) -> int
+{
+    auto& state = *static_cast<decompose_state*>(user);
+    SPDLOG_TRACE("Quadratic to ({}, {}), ({}, {})", control->x, control->y, to->x, to->y);
+    state.outline->curves.push_back(curve{ state.prev, to_point(control), to_point(to) });
+    state.prev = to_point(to);
+    extend_bounds(*state.outline, to_point(control));
+    extend_bounds(*state.outline, state.prev);
+    return 0;
+}
+
+auto cubic_to([[maybe_unused]] FT_Vector const* control1,
+              [[maybe_unused]] FT_Vector const* control2,
+              [[maybe_unused]] FT_Vector const* to,
+              void*) -> int
+{
+    SPDLOG_TRACE(
+        "Cubic to ({}, {}), ({}, {}), ({}, {})", control1->x, control1->y, control2->x, control2->y, to->x, to->y);
+    return 0;
+}
+
+} // namespace
+
+auto curve_str(curve const& c) -> std::string
+{
+    return fmt::format("({}, {}), ({}, {}), ({}, {})", c.p1.x, c.p1.y, c.p2.x, c.p2.y, c.p3.x, c.p3.y);
+}
+
+auto load_glyph_outline(FT_Face face, FT_ULong const char_code, glyph_outline& outline) -> bool
+{
+    SPDLOG_DEBUG("Outline data for glyph #{}", char_code);
+
+    return load_glyph_outline_by_index(face, FT_Get_Char_Index(face, char_code), outline);
+}
+
+auto load_glyph_outline_by_index(FT_Face face, FT_UInt const glyph_index, glyph_outline& outline) -> bool
+{
+    {
+        phase_timer const timer{ phase::glyph_load };
+
+        if(FT_Load_Glyph(face, glyph_index, FT_LOAD_NO_SCALE)) {
+            spdlog::error("Could not load glyph index {}", glyph_index);
+            return false;
+        }
+    }
+
+    SPDLOG_DEBUG("Glyph metrics: w={}, h={}", face->glyph->metrics.width, face->glyph->metrics.height);
+
+    phase_timer const timer{ phase::decompose };
+
+    // Keep the curve buffer's capacity. Every segment ends on a point of its own, so n_points
+    // curves always suffice and decomposition never reallocates.
+    auto curves = std::move(outline.curves);
+    curves.clear();
+    curves.reserve(static_cast<std::size_t>(std::max(static_cast<int>(face->glyph->outline.n_points), 0)));
+    outline = glyph_outline{ std::move(curves) };
+
+    FT_Outline_Funcs f;
+
+    f.delta = 0;
+    f.shift = 0;
+
+    f.move_to = move_to;
+    f.line_to = line_to;
+    f.conic_to = conic_to;
+    f.cubic_to = cubic_to;
+
+    decompose_state state{ &outline, point{ 0.0F, 0.0F } };
+
+    if(FT_Outline_Decompose(&face->glyph->outline, &f, &state)) {
+        spdlog::error("Could not decompose outlines!");
+        return false;
+    }
+
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+    for(auto const& c : outline.curves) {
+        SPDLOG_TRACE("Draw quadratic: {}", curve_str(c));
+    }
+#endif
+
+    SPDLOG_DEBUG("MinX={}, MinY={}", outline.min_x, outline.min_y);
+    SPDLOG_DEBUG("MaxX={}, MaxY={}", outline.max_x, outline.max_y);
+
+    return true;
+}
+
+auto make_raster_params(glyph_outline const& outline, float const scale, pixel_format const format) -> raster_params
+{
+    phase_timer const timer{ phase::preprocess };
+
+    raster_params params;
+    params.scale = scale;
+    params.format = format;
+
+    // Without curves the bounds are still at their sentinels and would give a negative size.
+    if(outline.curves.empty()) {
+        params.width = 0;
+        params.height = 0;
+        params.min_x = 0.0F;
+        params.min_y = 0.0F;
+        return params;
+    }
+
+    params.width = static_cast<int>(outline.max_x * scale) - static_cast<int>(outline.min_x * scale);
+    params.height = static_cast<int>(outline.max_y * scale) - static_cast<int>(outline.min_y * scale);
+    params.min_x = outline.min_x;
+    params.min_y = outline.min_y;
+    return params;
+}
+
+auto make_distance_field_params(glyph_outline const& outline,
+                                float const scale,
+                                distance_field_type const type,
+                                float const range) -> distance_field_params
+{
+    distance_field_params params;
+    params.type = type;
+    params.scale = scale;
+    params.range = range;
+
+    // The default 0x0 field, as for the raster.
+    if(outline.curves.empty()) {
+        return params;
+    }
+
+    params.min_x = outline.min_x - range / scale;
+    params.min_y = outline.min_y - range / scale;
+    params.width = static_cast<int>(std::ceil((outline.max_x - outline.min_x) * scale + 2.0F * range));
+    params.height = static_cast<int>(std::ceil((outline.max_y - outline.min_y) * scale + 2.0F * range));
+    return params;
+}
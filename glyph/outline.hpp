@@ -0,0 +1,41 @@
+#ifndef BEZIER_OUTLINE_HPP
+#define BEZIER_OUTLINE_HPP
+
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "raster.hpp"
+#include "sdf.hpp"
+
+struct glyph_outline
+{
+    std::vector<curve> curves;
+    float min_x = 16384.0F;
+    float min_y = 16384.0F;
+    float max_x = -16384.0F;
+    float max_y = -16384.0F;
+};
+
+[[nodiscard]] auto curve_str(curve const& c) -> std::string;
+
+// Loads `char_code` from `face` in font units and converts its outline to quadratic curves.
+// Lines become degenerate quadratics; cubic segments are not supported and are skipped.
+[[nodiscard]] auto load_glyph_outline(FT_Face face, FT_ULong char_code, glyph_outline& outline) -> bool;
+[[nodiscard]] auto load_glyph_outline_by_index(FT_Face face, FT_UInt glyph_index, glyph_outline& outline) -> bool;
+
+// An outline without curves (a space, say) gives a 0x0 image.
+[[nodiscard]] auto make_raster_params(glyph_outline const& outline,
+                                      float scale,
+                                      pixel_format format = pixel_format::rgba) -> raster_params;
+
+// Fits the distance field around the outline with `range` pixels of padding on every side. An
+// outline without curves gives a 0x0 field.
+[[nodiscard]] auto make_distance_field_params(glyph_outline const& outline,
+                                              float scale,
+                                              distance_field_type type,
+                                              float range) -> distance_field_params;
+
+#endif // BEZIER_OUTLINE_HPP
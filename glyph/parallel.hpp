@@ -0,0 +1,52 @@
+#ifndef BEZIER_PARALLEL_HPP
+#define BEZIER_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+[[nodiscard]] inline auto worker_count(unsigned const requested = 0) -> unsigned
+{
+    if(requested > 0) {
+        return requested;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+// Calls `fn(i)` for every i in [0, count) from up to `threads` threads. Work items are handed
+// out one at a time, so uneven items still balance.
+template<typename F>
+auto parallel_for(std::size_t const count, unsigned const threads, F const& fn) -> void
+{
+    auto const n = static_cast<unsigned>(std::min<std::size_t>(worker_count(threads), count));
+
+    if(n <= 1) {
+        for(std::size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{ 0 };
+    auto const work = [&]() {
+        for(auto i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(n - 1);
+    for(unsigned i = 1; i < n; ++i) {
+        workers.emplace_back(work);
+    }
+
+    work();
+
+    for(auto& w : workers) {
+        w.join();
+    }
+}
+
+#endif // BEZIER_PARALLEL_HPP
@@ -0,0 +1,389 @@
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "bounded_queue.hpp"
+#include "metrics.hpp"
+#include "outline.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct glyph_job
+{
+    FT_ULong char_code = 0;
+    glyph_outline outline;
+    raster_params params{};
+    std::vector<std::uint8_t> pixels;
+    image_view image;
+    std::vector<std::uint8_t> encoded;
+};
+
+// `skipped` drops the glyph without counting it as a failure, e.g. a space has nothing to draw.
+enum class job_result
+{
+    ok,
+    skipped,
+    failed
+};
+
+using job_ptr = std::unique_ptr<glyph_job>;
+using job_queue = bounded_queue<job_ptr>;
+
+// Shared by all workers of one stage. The last worker to leave closes the stage's output
+// queue, which is how the end of the batch travels down the pipeline.
+struct stage_counters
+{
+    std::atomic<unsigned> active{ 0 };
+    std::atomic<std::size_t> items{ 0 };
+    std::atomic<std::int64_t> busy_ns{ 0 };
+    std::atomic<std::size_t> depth_sum{ 0 };
+    std::atomic<std::size_t> depth_max{ 0 };
+};
+
+auto sample_depth(stage_counters& counters, std::size_t const depth) -> void
+{
+    counters.depth_sum.fetch_add(depth, std::memory_order_relaxed);
+
+    auto seen = counters.depth_max.load(std::memory_order_relaxed);
+    while(depth > seen && !counters.depth_max.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {
+    }
+}
+
+// Curves with nothing to contribute to any ray: all three control points coincide. FreeType
+// emits these for closing segments of contours that already end on their start point.
+[[nodiscard]] auto is_degenerate(curve const& c) -> bool
+{
+    return c.p1.x == c.p2.x && c.p2.x == c.p3.x && c.p1.y == c.p2.y && c.p2.y == c.p3.y;
+}
+
+class pipeline
+{
+public:
+    explicit pipeline(pipeline_options const& opts)
+        : m_opts{ opts }
+        , m_preprocess_in{ opts.queue_capacity }
+        , m_raster_in{ opts.queue_capacity }
+        , m_encode_in{ opts.queue_capacity }
+        , m_spare{ 4 * opts.queue_capacity }
+    {
+    }
+
+    auto run(pipeline_stats& stats) -> bool
+    {
+        auto workers = m_opts.workers;
+        unsigned fixed = 0;
+
+        for(auto const n : workers) {
+            fixed += n;
+        }
+        for(auto& n : workers) {
+            if(n == 0) {
+                n = std::max(worker_count() > fixed ? worker_count() - fixed : 1U, 1U);
+            }
+        }
+
+        auto const start = clock_type::now();
+        std::vector<std::thread> threads;
+
+        spawn(threads, pipeline_stage::load, workers[0], [this]() { load_worker(); });
+        spawn(threads, pipeline_stage::preprocess, workers[1], [this]() {
+            consume(pipeline_stage::preprocess, m_preprocess_in, &m_raster_in, [this](glyph_job& job) {
+                return preprocess(job);
+            });
+        });
+        spawn(threads, pipeline_stage::raster, workers[2], [this]() {
+            consume(pipeline_stage::raster, m_raster_in, &m_encode_in, [](glyph_job& job) {
+                job.image = render_image(job.outline.curves, job.params, job.pixels);
+                return job_result::ok;
+            });
+        });
+        spawn(threads, pipeline_stage::encode, workers[3], [this]() {
+            consume(pipeline_stage::encode, m_encode_in, nullptr, [this](glyph_job& job) { return encode(job); });
+        });
+
+        for(auto& t : threads) {
+            t.join();
+        }
+
+        stats.wall_seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+        stats.failed = m_failed.load();
+
+        for(std::size_t i = 0; i < pipeline_stage_count; ++i) {
+            auto const& c = m_counters[i];
+            auto& s = stats.stages[i];
+
+            s.workers = workers[i];
+            s.items = c.items.load();
+            s.busy_seconds = static_cast<double>(c.busy_ns.load()) * 1e-9;
+            s.max_queue_depth = c.depth_max.load();
+            s.mean_queue_depth = s.items > 0 ? static_cast<double>(c.depth_sum.load()) / s.items : 0.0;
+        }
+
+        return stats.failed == 0;
+    }
+
+private:
+    template<typename F>
+    auto spawn(std::vector<std::thread>& threads, pipeline_stage const stage, unsigned const n, F fn) -> void
+    {
+        m_counters[static_cast<std::size_t>(stage)].active.store(n);
+        for(unsigned i = 0; i < n; ++i) {
+            threads.emplace_back(fn);
+        }
+    }
+
+    auto leave(pipeline_stage const stage, job_queue* out) -> void
+    {
+        if(m_counters[static_cast<std::size_t>(stage)].active.fetch_sub(1) == 1 && out != nullptr) {
+            out->close();
+        }
+    }
+
+    // Jobs go back to the load stage once done, so their curve, pixel and encoded buffers keep
+    // their capacity and a long batch stops allocating after the first few glyphs. Anything the
+    // spare queue has no room for is freed.
+    [[nodiscard]] auto acquire() -> job_ptr
+    {
+        job_ptr job;
+        if(!m_spare.try_pop(job)) {
+            job = std::make_unique<glyph_job>();
+        }
+        return job;
+    }
+
+    auto recycle(job_ptr& job) -> void
+    {
+        if(job != nullptr && !m_spare.try_push(job)) {
+            job.reset();
+        }
+    }
+
+    auto fail(glyph_job const& job, pipeline_stage const stage) -> void
+    {
+        spdlog::error("Glyph #{} failed in the {} stage", job.char_code, pipeline_stage_name(stage));
+        m_failed.fetch_add(1);
+    }
+
+    // Runs one glyph's share of `stage`, adding it to the stage's busy time and to the timeline.
+    template<typename F>
+    static auto timed(pipeline_stage const stage, FT_ULong const char_code, std::int64_t& busy, F fn)
+    {
+        trace_span const span{ pipeline_stage_name(stage), "pipeline", "char", static_cast<std::int64_t>(char_code) };
+
+        auto const start = clock_type::now();
+        auto const result = fn();
+        busy += std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count();
+
+        return result;
+    }
+
+    // Pulls from `in` until it is closed and drained, hands successful jobs to `out`.
+    template<typename F>
+    auto consume(pipeline_stage const stage, job_queue& in, job_queue* out, F process) -> void
+    {
+        auto& counters = m_counters[static_cast<std::size_t>(stage)];
+        std::int64_t busy = 0;
+        job_ptr job;
+
+        set_trace_thread_name(pipeline_stage_name(stage));
+
+        while(in.pop(job)) {
+            sample_depth(counters, in.size());
+
+            auto const result = timed(stage, job->char_code, busy, [&]() { return process(*job); });
+
+            counters.items.fetch_add(1, std::memory_order_relaxed);
+
+            if(result == job_result::failed) {
+                fail(*job, stage);
+            }
+            else if(result == job_result::ok && out != nullptr) {
+                out->push(std::move(job));
+            }
+            recycle(job);
+        }
+
+        counters.busy_ns.fetch_add(busy);
+        leave(stage, out);
+    }
+
+    auto load_worker() -> void
+    {
+        auto& counters = m_counters[static_cast<std::size_t>(pipeline_stage::load)];
+        std::int64_t busy = 0;
+
+        FT_Library library = nullptr;
+        FT_Face face = nullptr;
+
+        set_trace_thread_name(pipeline_stage_name(pipeline_stage::load));
+
+        bool opened = false;
+        {
+            phase_timer const timer{ phase::font_open };
+            opened = !FT_Init_FreeType(&library) && !FT_New_Face(library, m_opts.font_path.c_str(), 0, &face);
+        }
+
+        if(!opened) {
+            spdlog::error("Could not open font {}", m_opts.font_path);
+            m_failed.fetch_add(1);
+        }
+        else {
+            for(auto i = m_next_char.fetch_add(1); i < m_opts.chars.size(); i = m_next_char.fetch_add(1)) {
+                auto job = acquire();
+                job->char_code = m_opts.chars[i];
+
+                bool const ok = timed(pipeline_stage::load, job->char_code, busy, [&]() {
+                    return load_glyph_outline(face, job->char_code, job->outline);
+                });
+
+                counters.items.fetch_add(1, std::memory_order_relaxed);
+
+                if(ok) {
+                    m_preprocess_in.push(std::move(job));
+                }
+                else {
+                    fail(*job, pipeline_stage::load);
+                    recycle(job);
+                }
+            }
+        }
+
+        if(face != nullptr) {
+            FT_Done_Face(face);
+        }
+        if(library != nullptr) {
+            FT_Done_FreeType(library);
+        }
+
+        counters.busy_ns.fetch_add(busy);
+        leave(pipeline_stage::load, &m_preprocess_in);
+    }
+
+    auto preprocess(glyph_job& job) const -> job_result
+    {
+        auto& curves = job.outline.curves;
+        {
+            phase_timer const timer{ phase::preprocess };
+            curves.erase(std::remove_if(curves.begin(), curves.end(), is_degenerate), curves.end());
+        }
+
+        if(curves.empty()) {
+            spdlog::info("Glyph #{} has no outline, skipping", job.char_code);
+            return job_result::skipped;
+        }
+
+        job.params = make_raster_params(job.outline, m_opts.scale, m_opts.format);
+        return job.params.width > 0 && job.params.height > 0 ? job_result::ok : job_result::failed;
+    }
+
+    auto encode(glyph_job& job) const -> job_result
+    {
+        auto const path = pipeline_output_path(m_opts.output_pattern, job.char_code);
+
+        return encode_image(job.image, m_opts.output_format, job.encoded) && write_file(path.c_str(), job.encoded)
+                   ? job_result::ok
+                   : job_result::failed;
+    }
+
+    pipeline_options const& m_opts;
+    std::atomic<std::size_t> m_next_char{ 0 };
+    std::atomic<std::size_t> m_failed{ 0 };
+    job_queue m_preprocess_in;
+    job_queue m_raster_in;
+    job_queue m_encode_in;
+    job_queue m_spare;
+    std::array<stage_counters, pipeline_stage_count> m_counters;
+};
+
+} // namespace
+
+auto pipeline_stage_name(pipeline_stage const stage) -> char const*
+{
+    switch(stage) {
+    case pipeline_stage::load:
+        return "load";
+    case pipeline_stage::preprocess:
+        return "preprocess";
+    case pipeline_stage::raster:
+        return "raster";
+    case pipeline_stage::encode:
+        return "encode";
+    }
+    return "unknown";
+}
+
+auto pipeline_output_path(std::string const& pattern, FT_ULong const char_code) -> std::string
+{
+    auto const code = std::to_string(char_code);
+    auto const placeholder = pattern.find("{}");
+
+    if(placeholder != std::string::npos) {
+        return pattern.substr(0, placeholder) + code + pattern.substr(placeholder + 2);
+    }
+
+    auto const slash = pattern.find_last_of('/');
+    auto dot = pattern.find_last_of('.');
+
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        dot = pattern.size();
+    }
+
+    return pattern.substr(0, dot) + "_" + code + pattern.substr(dot);
+}
+
+auto parse_pipeline_workers(std::string const& value, std::array<unsigned, pipeline_stage_count>& workers) -> bool
+{
+    char const* p = value.c_str();
+
+    for(std::size_t i = 0; i < pipeline_stage_count; ++i) {
+        char* end = nullptr;
+        auto const n = std::strtoul(p, &end, 10);
+
+        if(end == p || (i + 1 < pipeline_stage_count ? *end != ',' : *end != '\0')) {
+            return false;
+        }
+
+        workers[i] = static_cast<unsigned>(n);
+        p = end + 1;
+    }
+
+    // The load stage is the only one that cannot size itself.
+    return workers[0] > 0;
+}
+
+auto run_pipeline(pipeline_options const& opts, pipeline_stats& stats) -> bool
+{
+    pipeline p{ opts };
+    return p.run(stats);
+}
+
+auto log_pipeline_stats(pipeline_stats const& stats) -> void
+{
+    spdlog::info("Pipeline: {:.3f} s wall, {} failed", stats.wall_seconds, stats.failed);
+
+    for(std::size_t i = 0; i < pipeline_stage_count; ++i) {
+        auto const& s = stats.stages[i];
+        auto const capacity = stats.wall_seconds * s.workers;
+
+        spdlog::info("  {:<10} workers={} items={} busy={:.3f} s ({:.0f}%) queue mean={:.1f} max={}",
+                     pipeline_stage_name(static_cast<pipeline_stage>(i)),
+                     s.workers,
+                     s.items,
+                     s.busy_seconds,
+                     capacity > 0.0 ? 100.0 * s.busy_seconds / capacity : 0.0,
+                     s.mean_queue_depth,
+                     s.max_queue_depth);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef BEZIER_PIPELINE_HPP
+#define BEZIER_PIPELINE_HPP
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "encode.hpp"
+#include "raster.hpp"
+
+// Batch rendering runs as four stages, each with its own workers, connected by bounded queues:
+// FreeType load and decompose, curve preprocessing, rasterization, and encode plus write. A
+// glyph moves to the next stage as soon as it is done, so encoding glyph N overlaps
+// rasterizing glyph N + 1.
+enum class pipeline_stage
+{
+    load,
+    preprocess,
+    raster,
+    encode
+};
+
+constexpr std::size_t pipeline_stage_count = 4;
+
+[[nodiscard]] auto pipeline_stage_name(pipeline_stage stage) -> char const*;
+
+struct pipeline_options
+{
+    std::string font_path;
+    std::vector<FT_ULong> chars;
+    // "{}" is replaced by the character code. Without it, "_<code>" goes before the extension.
+    std::string output_pattern = "img.png";
+    float scale = 1.0F;
+    pixel_format format = pixel_format::rgba;
+    image_format output_format = image_format::png;
+    // Workers per stage, in `pipeline_stage` order. 0 gives the stage the cores the others
+    // leave over. Every load worker opens its own FT_Face, since faces are not thread-safe.
+    std::array<unsigned, pipeline_stage_count> workers{ 1, 1, 0, 1 };
+    std::size_t queue_capacity = 16;
+};
+
+// `queue_depth` is sampled from the stage's input queue every time a worker takes an item; a
+// stage whose queue stays full is the bottleneck, one whose queue stays empty is starved.
+struct stage_stats
+{
+    unsigned workers = 0;
+    std::size_t items = 0;
+    double busy_seconds = 0.0;
+    double mean_queue_depth = 0.0;
+    std::size_t max_queue_depth = 0;
+};
+
+struct pipeline_stats
+{
+    std::array<stage_stats, pipeline_stage_count> stages;
+    std::size_t failed = 0;
+    double wall_seconds = 0.0;
+};
+
+[[nodiscard]] auto pipeline_output_path(std::string const& pattern, FT_ULong char_code) -> std::string;
+
+// Parses "load,preprocess,raster,encode" worker counts, e.g. "1,1,6,2".
+[[nodiscard]] auto parse_pipeline_workers(std::string const& value,
+                                          std::array<unsigned, pipeline_stage_count>& workers) -> bool;
+
+// Renders every glyph of `opts.chars` to its own file. Returns false if any glyph failed; the
+// others are still written.
+[[nodiscard]] auto run_pipeline(pipeline_options const& opts, pipeline_stats& stats) -> bool;
+
+auto log_pipeline_stats(pipeline_stats const& stats) -> void;
+
+#endif // BEZIER_PIPELINE_HPP
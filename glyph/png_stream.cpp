@@ -0,0 +1,422 @@
+#include "png_stream.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "metrics.hpp"
+#include "stb_image_write.h"
+
+namespace {
+
+constexpr std::size_t idat_chunk_size = 1 << 16;
+
+auto put_u32(std::uint8_t* dst, std::uint32_t const v) -> void
+{
+    dst[0] = static_cast<std::uint8_t>(v >> 24);
+    dst[1] = static_cast<std::uint8_t>(v >> 16);
+    dst[2] = static_cast<std::uint8_t>(v >> 8);
+    dst[3] = static_cast<std::uint8_t>(v);
+}
+
+auto paeth(int const a, int const b, int const c) -> int
+{
+    int const p = a + b - c;
+    int const pa = std::abs(p - a);
+    int const pb = std::abs(p - b);
+    int const pc = std::abs(p - c);
+
+    if(pa <= pb && pa <= pc) {
+        return a;
+    }
+    if(pb <= pc) {
+        return b;
+    }
+    return c;
+}
+
+// Applies PNG filter `type` to `row`, writing the filter byte followed by the filtered
+// scanline. `prev` is all zeroes for the first row, which is what the spec mandates.
+auto apply_filter(int const type,
+                  std::uint8_t const* row,
+                  std::uint8_t const* prev,
+                  int const len,
+                  int const bpp,
+                  std::uint8_t* out) -> void
+{
+    out[0] = static_cast<std::uint8_t>(type);
+    ++out;
+
+    for(int i = 0; i < len; ++i) {
+        int const a = i >= bpp ? row[i - bpp] : 0;
+        int const b = prev[i];
+        int const c = i >= bpp ? prev[i - bpp] : 0;
+        int predicted = 0;
+
+        switch(type) {
+        case 1: {
+            predicted = a;
+            break;
+        }
+        case 2: {
+            predicted = b;
+            break;
+        }
+        case 3: {
+            predicted = (a + b) >> 1;
+            break;
+        }
+        case 4: {
+            predicted = paeth(a, b, c);
+            break;
+        }
+        default: {
+            break;
+        }
+        }
+
+        out[i] = static_cast<std::uint8_t>(row[i] - predicted);
+    }
+}
+
+// Same heuristic as stb_image_write: the filter whose output has the smallest sum of
+// absolute values (as signed bytes) tends to compress best.
+auto filter_cost(std::uint8_t const* filtered, int const len) -> long
+{
+    long cost = 0;
+    for(int i = 0; i < len; ++i) {
+        cost += std::abs(static_cast<int>(static_cast<signed char>(filtered[i])));
+    }
+    return cost;
+}
+
+[[nodiscard]] auto fixed_filter_type(png_filter_mode const mode) -> int
+{
+    switch(mode) {
+    case png_filter_mode::sub: {
+        return 1;
+    }
+    case png_filter_mode::up: {
+        return 2;
+    }
+    case png_filter_mode::average: {
+        return 3;
+    }
+    case png_filter_mode::paeth: {
+        return 4;
+    }
+    default: {
+        return 0;
+    }
+    }
+}
+
+} // namespace
+
+auto parse_png_filter_mode(std::string const& name, png_filter_mode& mode) -> bool
+{
+    if(name == "adaptive") {
+        mode = png_filter_mode::adaptive;
+    }
+    else if(name == "sampled") {
+        mode = png_filter_mode::sampled;
+    }
+    else if(name == "none") {
+        mode = png_filter_mode::none;
+    }
+    else if(name == "sub") {
+        mode = png_filter_mode::sub;
+    }
+    else if(name == "up") {
+        mode = png_filter_mode::up;
+    }
+    else if(name == "average") {
+        mode = png_filter_mode::average;
+    }
+    else if(name == "paeth") {
+        mode = png_filter_mode::paeth;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+auto sampled_png_filter(std::uint8_t const* row,
+                        std::uint8_t const* prev,
+                        int const len,
+                        int const bpp,
+                        int const step) -> int
+{
+    int best_type = 0;
+    long best_cost = -1;
+
+    for(int type = 0; type < 5; ++type) {
+        long cost = 0;
+
+        for(int px = 0; px < len; px += step * bpp) {
+            for(int i = px; i < px + bpp && i < len; ++i) {
+                int const a = i >= bpp ? row[i - bpp] : 0;
+                int const b = prev != nullptr ? prev[i] : 0;
+                int const c = prev != nullptr && i >= bpp ? prev[i - bpp] : 0;
+                int predicted = 0;
+
+                switch(type) {
+                case 1: {
+                    predicted = a;
+                    break;
+                }
+                case 2: {
+                    predicted = b;
+                    break;
+                }
+                case 3: {
+                    predicted = (a + b) >> 1;
+                    break;
+                }
+                case 4: {
+                    predicted = paeth(a, b, c);
+                    break;
+                }
+                default: {
+                    break;
+                }
+                }
+
+                cost += std::abs(static_cast<int>(static_cast<signed char>(row[i] - predicted)));
+            }
+        }
+
+        if(best_cost < 0 || cost < best_cost) {
+            best_cost = cost;
+            best_type = type;
+        }
+    }
+
+    return best_type;
+}
+
+auto set_png_filter_mode(png_filter_mode const mode, int const sample_step) -> void
+{
+    switch(mode) {
+    case png_filter_mode::adaptive: {
+        stbi_write_force_png_filter = -1;
+        stbi_write_png_filter_sample_step = 1;
+        break;
+    }
+    case png_filter_mode::sampled: {
+        stbi_write_force_png_filter = -1;
+        stbi_write_png_filter_sample_step = std::max(sample_step, 1);
+        break;
+    }
+    default: {
+        stbi_write_force_png_filter = fixed_filter_type(mode);
+        stbi_write_png_filter_sample_step = 1;
+        break;
+    }
+    }
+}
+
+png_stream::~png_stream()
+{
+    if(m_deflating) {
+        deflateEnd(&m_zs);
+    }
+    if(m_file != nullptr) {
+        std::fclose(m_file);
+    }
+}
+
+auto png_stream::open(char const* filename, int const width, int const height, int const channels, int const level)
+    -> bool
+{
+    static std::array<std::uint8_t, 5> const color_types = { 0, 0, 4, 2, 6 };
+
+    if(channels < 1 || channels > 4 || width <= 0 || height <= 0) {
+        spdlog::error("Invalid PNG stream dimensions: w={}, h={}, channels={}", width, height, channels);
+        return false;
+    }
+
+    m_file = std::fopen(filename, "wb");
+    if(m_file == nullptr) {
+        spdlog::error("Could not open {} for writing!", filename);
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_channels = channels;
+    m_rows_written = 0;
+
+    auto const row_bytes = static_cast<std::size_t>(width) * channels;
+    m_prev_row.assign(row_bytes, 0);
+    m_filtered.resize(row_bytes + 1);
+    m_candidate.resize(row_bytes + 1);
+    m_idat.resize(idat_chunk_size);
+
+    m_zs = z_stream{};
+    if(deflateInit(&m_zs, level) != Z_OK) {
+        spdlog::error("Could not initialize deflate stream!");
+        return false;
+    }
+    m_deflating = true;
+
+    m_zs.next_out = m_idat.data();
+    m_zs.avail_out = static_cast<uInt>(m_idat.size());
+
+    static std::array<std::uint8_t, 8> const signature = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if(std::fwrite(signature.data(), 1, signature.size(), m_file) != signature.size()) {
+        return false;
+    }
+
+    std::array<std::uint8_t, 13> header{};
+    put_u32(header.data(), static_cast<std::uint32_t>(width));
+    put_u32(header.data() + 4, static_cast<std::uint32_t>(height));
+    header[8] = 8;
+    header[9] = color_types[channels];
+
+    return write_chunk("IHDR", header.data(), header.size());
+}
+
+auto png_stream::set_filter_mode(png_filter_mode const mode, int const sample_step) -> void
+{
+    m_filter_mode = mode;
+    m_sample_step = std::max(sample_step, 1);
+}
+
+auto png_stream::write_rows(std::uint8_t const* rows, int const row_count, std::size_t const stride) -> bool
+{
+    phase_timer const timer{ phase::encode };
+
+    if(!m_deflating || m_rows_written + row_count > m_height) {
+        spdlog::error("PNG stream received more rows than announced in its header!");
+        return false;
+    }
+
+    for(int i = 0; i < row_count; ++i) {
+        std::uint8_t const* row = rows + static_cast<std::size_t>(i) * stride;
+
+        filter_row(row);
+
+        m_zs.next_in = m_filtered.data();
+        m_zs.avail_in = static_cast<uInt>(m_filtered.size());
+
+        if(!deflate_pending(Z_NO_FLUSH)) {
+            return false;
+        }
+
+        std::memcpy(m_prev_row.data(), row, m_prev_row.size());
+        ++m_rows_written;
+    }
+
+    return true;
+}
+
+auto png_stream::close() -> bool
+{
+    phase_timer const timer{ phase::write };
+
+    if(!m_deflating) {
+        return false;
+    }
+    if(m_rows_written != m_height) {
+        spdlog::error("PNG stream closed after {} of {} rows!", m_rows_written, m_height);
+        return false;
+    }
+
+    m_zs.next_in = nullptr;
+    m_zs.avail_in = 0;
+
+    bool ok = deflate_pending(Z_FINISH);
+
+    auto const pending = m_idat.size() - m_zs.avail_out;
+    if(ok && pending > 0) {
+        ok = write_chunk("IDAT", m_idat.data(), pending);
+    }
+
+    deflateEnd(&m_zs);
+    m_deflating = false;
+
+    ok = ok && write_chunk("IEND", nullptr, 0);
+    ok = (std::fclose(m_file) == 0) && ok;
+    m_file = nullptr;
+
+    return ok;
+}
+
+auto png_stream::write_chunk(char const* type, std::uint8_t const* data, std::size_t const size) -> bool
+{
+    std::array<std::uint8_t, 8> head{};
+    put_u32(head.data(), static_cast<std::uint32_t>(size));
+    std::memcpy(head.data() + 4, type, 4);
+
+    auto crc = crc32(0L, head.data() + 4, 4);
+    if(size > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(size));
+    }
+
+    std::array<std::uint8_t, 4> tail{};
+    put_u32(tail.data(), static_cast<std::uint32_t>(crc));
+
+    return std::fwrite(head.data(), 1, head.size(), m_file) == head.size() &&
+           (size == 0 || std::fwrite(data, 1, size, m_file) == size) &&
+           std::fwrite(tail.data(), 1, tail.size(), m_file) == tail.size();
+}
+
+auto png_stream::deflate_pending(int const flush) -> bool
+{
+    while(true) {
+        auto const status = deflate(&m_zs, flush);
+
+        if(status == Z_STREAM_ERROR) {
+            spdlog::error("Deflate stream error!");
+            return false;
+        }
+
+        bool const done = flush == Z_FINISH ? status == Z_STREAM_END : m_zs.avail_in == 0 && m_zs.avail_out != 0;
+
+        if(m_zs.avail_out == 0) {
+            if(!write_chunk("IDAT", m_idat.data(), m_idat.size())) {
+                spdlog::error("Could not write IDAT chunk!");
+                return false;
+            }
+            m_zs.next_out = m_idat.data();
+            m_zs.avail_out = static_cast<uInt>(m_idat.size());
+        }
+
+        if(done) {
+            return true;
+        }
+    }
+}
+
+auto png_stream::filter_row(std::uint8_t const* row) -> void
+{
+    auto const len = static_cast<int>(m_prev_row.size());
+
+    if(m_filter_mode != png_filter_mode::adaptive && m_filter_mode != png_filter_mode::sampled) {
+        apply_filter(fixed_filter_type(m_filter_mode), row, m_prev_row.data(), len, m_channels, m_filtered.data());
+        return;
+    }
+
+    if(m_filter_mode == png_filter_mode::sampled) {
+        auto const type = sampled_png_filter(row, m_prev_row.data(), len, m_channels, m_sample_step);
+        apply_filter(type, row, m_prev_row.data(), len, m_channels, m_filtered.data());
+        return;
+    }
+
+    long best_cost = -1;
+
+    for(int type = 0; type < 5; ++type) {
+        apply_filter(type, row, m_prev_row.data(), len, m_channels, m_candidate.data());
+
+        auto const cost = filter_cost(m_candidate.data() + 1, len);
+        if(best_cost < 0 || cost < best_cost) {
+            best_cost = cost;
+            m_filtered.swap(m_candidate);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef BEZIER_PNG_STREAM_HPP
+#define BEZIER_PNG_STREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+// How each scanline's PNG filter is chosen. `adaptive` tries all five filters on every byte,
+// `sampled` scores them on every Nth pixel only, the rest always use the same filter.
+enum class png_filter_mode
+{
+    adaptive,
+    sampled,
+    none,
+    sub,
+    up,
+    average,
+    paeth
+};
+
+constexpr int default_filter_sample_step = 8;
+
+[[nodiscard]] auto parse_png_filter_mode(std::string const& name, png_filter_mode& mode) -> bool;
+
+// The filter type (0-4) whose output, summed as absolute signed bytes over every `step`th pixel
+// of `row`, is smallest. `prev` is the row above, or null for the first row. Both the `sampled`
+// streaming writer and stb_image_write use it (see STBIW_ESTIMATE_PNG_FILTER in stb.cpp).
+[[nodiscard]] auto sampled_png_filter(std::uint8_t const* row, std::uint8_t const* prev, int len, int bpp, int step)
+    -> int;
+
+// Applies the mode to stb_image_write's globals, for everything encoded through stbi_write_png*.
+auto set_png_filter_mode(png_filter_mode mode, int sample_step = default_filter_sample_step) -> void;
+
+// Writes a PNG incrementally: rows are filtered and fed to a single deflate stream as they
+// arrive and IDAT chunks are flushed whenever the compressed buffer fills up, so only the
+// previous row and one chunk worth of output are held in memory.
+class png_stream
+{
+public:
+    png_stream() = default;
+    png_stream(png_stream const&) = delete;
+    png_stream(png_stream&&) = delete;
+    ~png_stream();
+
+    auto operator=(png_stream const&) -> png_stream& = delete;
+    auto operator=(png_stream&&) -> png_stream& = delete;
+
+    [[nodiscard]] auto open(char const* filename, int width, int height, int channels, int level = 8) -> bool;
+    auto set_filter_mode(png_filter_mode mode, int sample_step = default_filter_sample_step) -> void;
+    [[nodiscard]] auto write_rows(std::uint8_t const* rows, int row_count, std::size_t stride) -> bool;
+    [[nodiscard]] auto close() -> bool;
+
+private:
+    [[nodiscard]] auto write_chunk(char const* type, std::uint8_t const* data, std::size_t size) -> bool;
+    [[nodiscard]] auto deflate_pending(int flush) -> bool;
+
+    auto filter_row(std::uint8_t const* row) -> void;
+
+    std::FILE* m_file = nullptr;
+    z_stream m_zs{};
+    bool m_deflating = false;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_channels = 0;
+    int m_rows_written = 0;
+
+    png_filter_mode m_filter_mode = png_filter_mode::adaptive;
+    int m_sample_step = default_filter_sample_step;
+
+    std::vector<std::uint8_t> m_prev_row;
+    std::vector<std::uint8_t> m_filtered;
+    std::vector<std::uint8_t> m_candidate;
+    std::vector<std::uint8_t> m_idat;
+};
+
+#endif // BEZIER_PNG_STREAM_HPP
@@ -0,0 +1,150 @@
+#include "raster.hpp"
+
+#include <cmath>
+
+#include "metrics.hpp"
+#include "trace.hpp"
+
+auto eval_curve(float const y1, float const y2, float const y3, float const t) -> float
+{
+    float const it = 1.0F - t;
+
+    return it * it * y1 + 2.0F * t * it * y2 + t * t * y3;
+}
+
+auto trace_ray(std::vector<curve> const& curves,
+               float const fx,
+               float const fy,
+               float const ppem,
+               orientation const orient,
+               ray_counters* const counters) -> float
+{
+    float coverage = 0.0F;
+    std::uint64_t skipped = 0;
+
+    for(auto const& crv : curves) {
+        auto x1 = crv.p1.x - fx;
+        auto x2 = crv.p2.x - fx;
+        auto x3 = crv.p3.x - fx;
+
+        auto y1 = crv.p1.y - fy;
+        auto y2 = crv.p2.y - fy;
+        auto y3 = crv.p3.y - fy;
+
+        if(orient == orientation::vertical) {
+            x1 = crv.p1.y - fy;
+            x2 = crv.p2.y - fy;
+            x3 = crv.p3.y - fy;
+
+            y1 = crv.p1.x - fx;
+            y2 = crv.p2.x - fx;
+            y3 = crv.p3.x - fx;
+        }
+
+        auto const a = y1 - 2 * y2 + y3;
+        auto const b = y1 - y2;
+        auto const c = y1;
+
+        float t1 = 0.0F;
+        float t2 = 0.0F;
+
+        if(std::abs(a) < 0.0001F) {
+            t1 = t2 = c / (2.0F * b);
+        }
+        else {
+            float const root = std::sqrt(std::max(b * b - a * c, 0.0F));
+            t1 = (b - root) / a;
+            t2 = (b + root) / a;
+        }
+
+        auto const num = ((y1 > 0.0F) ? 2 : 0) + ((y2 > 0.0F) ? 4 : 0) + ((y3 > 0.0F) ? 8 : 0);
+        auto const sh = 0x2E74 >> num;
+
+        if((sh & 3) == 0) {
+            ++skipped;
+            continue;
+        }
+
+        if((sh & 1) != 0) {
+            float const r1 = eval_curve(x1, x2, x3, t1);
+            coverage += clamp(r1 * ppem + 0.5F, 0.0F, 1.0F);
+        }
+        if((sh & 2) != 0) {
+            float const r2 = eval_curve(x1, x2, x3, t2);
+            coverage -= clamp(r2 * ppem + 0.5F, 0.0F, 1.0F);
+        }
+    }
+
+    if(counters != nullptr) {
+        counters->curves_visited += curves.size();
+        counters->roots_solved += curves.size();
+        counters->early_exits += skipped;
+    }
+
+    return coverage;
+}
+
+auto render_rows(std::vector<curve> const& curves,
+                 raster_params const& params,
+                 int const first_row,
+                 int const row_count,
+                 std::uint8_t* const dst,
+                 std::size_t const stride) -> void
+{
+    phase_timer const timer{ phase::raster };
+    trace_span const span{ "rows", "raster", "first_row", first_row };
+
+    // Distances come out in outline units; one pixel is `scale` of them on both axes, which
+    // makes the antialiasing ramp one pixel wide.
+    float const ppem = params.scale;
+    int const channels = channel_count(params.format);
+
+    ray_counters ray_stats;
+    ray_counters* const stats = metrics_enabled() ? &ray_stats : nullptr;
+
+    for(int row = 0; row < row_count; ++row) {
+        int const y = params.height - 1 - (first_row + row);
+        std::uint8_t* const line = dst + static_cast<std::size_t>(row) * stride;
+
+        for(int x = 0; x < params.width; ++x) {
+            auto const fx = float(x) / params.scale + params.min_x;
+            auto const fy = float(y) / params.scale + params.min_y;
+
+            float const coverage_h =
+                std::min(std::abs(trace_ray(curves, fx, fy, ppem, orientation::horizontal, stats)), 1.0F);
+            float const coverage_v =
+                std::min(std::abs(trace_ray(curves, fx, fy, ppem, orientation::vertical, stats)), 1.0F);
+            float const avg_coverage = (coverage_h + coverage_v) / 2.0F;
+
+            if(params.format == pixel_format::coverage) {
+                line[x] = 255 * avg_coverage;
+                continue;
+            }
+
+            line[x * channels] = 255 * avg_coverage;
+            line[x * channels + 1] = 128 * avg_coverage;
+            line[x * channels + 2] = 64 * avg_coverage;
+            line[x * channels + 3] = 255;
+        }
+    }
+
+    if(stats != nullptr) {
+        add_count(counter::curves_visited, ray_stats.curves_visited);
+        add_count(counter::roots_solved, ray_stats.roots_solved);
+        add_count(counter::early_exits, ray_stats.early_exits);
+        add_count(counter::pixels_shaded, static_cast<std::uint64_t>(params.width) * row_count);
+    }
+}
+
+auto render_image(std::vector<curve> const& curves, raster_params const& params, std::vector<std::uint8_t>& pixels)
+    -> image_view
+{
+    int const channels = channel_count(params.format);
+    auto const stride = static_cast<std::size_t>(params.width) * channels;
+
+    pixels.resize(stride * params.height);
+
+    render_rows(curves, params, 0, params.height, pixels.data(), stride);
+
+    return image_view{ pixels.data(), params.width, params.height, channels, stride };
+}
@@ -0,0 +1,100 @@
+#ifndef BEZIER_RASTER_HPP
+#define BEZIER_RASTER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template<typename T>
+auto clamp(T const x, T const a, T const b) -> T
+{
+    return std::min(std::max(x, a), b);
+}
+
+struct point
+{
+    float x;
+    float y;
+};
+
+struct curve
+{
+    point p1;
+    point p2;
+    point p3;
+};
+
+enum class orientation
+{
+    horizontal,
+    vertical
+};
+
+// `rgba` is the tinted preview the renderer always produced, `coverage` is one byte of raw
+// coverage per pixel for callers that do their own compositing.
+enum class pixel_format
+{
+    rgba,
+    coverage
+};
+
+[[nodiscard]] constexpr auto channel_count(pixel_format const format) -> int
+{
+    return format == pixel_format::rgba ? 4 : 1;
+}
+
+// Maps output pixels to outline space. Rows are numbered top to bottom as they appear in the
+// image, while the outline's y axis points up, so row `r` samples `y = height - 1 - r`.
+struct raster_params
+{
+    int width;
+    int height;
+    float min_x;
+    float min_y;
+    float scale = 1.0F;
+    pixel_format format = pixel_format::rgba;
+};
+
+struct image_view
+{
+    std::uint8_t const* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::size_t stride = 0;
+};
+
+// Work done by `trace_ray`, accumulated across calls. A curve whose end and control points all
+// lie on one side of the ray is an early exit: its roots cannot cross the ray and add nothing.
+struct ray_counters
+{
+    std::uint64_t curves_visited = 0;
+    std::uint64_t roots_solved = 0;
+    std::uint64_t early_exits = 0;
+};
+
+auto eval_curve(float y1, float y2, float y3, float t) -> float;
+
+auto trace_ray(std::vector<curve> const& curves,
+               float fx,
+               float fy,
+               float ppem,
+               orientation orient = orientation::horizontal,
+               ray_counters* counters = nullptr) -> float;
+
+// Shades rows [first_row, first_row + row_count) into `dst`, which holds `row_count` rows of
+// `stride` bytes each.
+auto render_rows(std::vector<curve> const& curves,
+                 raster_params const& params,
+                 int first_row,
+                 int row_count,
+                 std::uint8_t* dst,
+                 std::size_t stride) -> void;
+
+// Renders the whole image into `pixels`, reusing its capacity when it is already large enough.
+// The returned view points into `pixels`.
+auto render_image(std::vector<curve> const& curves, raster_params const& params, std::vector<std::uint8_t>& pixels)
+    -> image_view;
+
+#endif // BEZIER_RASTER_HPP
@@ -0,0 +1,164 @@
+#include "reference.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "trace.hpp"
+
+namespace {
+
+// A curve piece along which y only grows or only shrinks, so a horizontal line meets it at most
+// once. `dir` is +1 when y grows from p1 to p3.
+struct monotone_piece
+{
+    curve c;
+    double y_min;
+    double y_max;
+    int dir;
+};
+
+struct crossing
+{
+    double x;
+    int dir;
+};
+
+auto lerp(point const a, point const b, float const t) -> point
+{
+    return point{ a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t };
+}
+
+auto add_piece(curve const& c, std::vector<monotone_piece>& pieces) -> void
+{
+    if(c.p1.y == c.p3.y) {
+        return;
+    }
+
+    bool const up = c.p3.y > c.p1.y;
+    pieces.push_back(monotone_piece{ c,
+                                     up ? c.p1.y : c.p3.y,
+                                     up ? c.p3.y : c.p1.y,
+                                     up ? 1 : -1 });
+}
+
+// Splits every curve at its y extremum.
+auto monotone_pieces(std::vector<curve> const& curves) -> std::vector<monotone_piece>
+{
+    std::vector<monotone_piece> pieces;
+    pieces.reserve(curves.size() * 2);
+
+    for(auto const& c : curves) {
+        float const a = c.p1.y - 2.0F * c.p2.y + c.p3.y;
+        float const t = a != 0.0F ? (c.p1.y - c.p2.y) / a : 0.0F;
+
+        if(t <= 0.0F || t >= 1.0F) {
+            add_piece(c, pieces);
+            continue;
+        }
+
+        point const q1 = lerp(c.p1, c.p2, t);
+        point const q2 = lerp(c.p2, c.p3, t);
+        point const mid = lerp(q1, q2, t);
+
+        add_piece(curve{ c.p1, q1, mid }, pieces);
+        add_piece(curve{ mid, q2, c.p3 }, pieces);
+    }
+
+    return pieces;
+}
+
+// Where the line y = sy crosses `piece`, which it is known to span.
+auto crossing_x(monotone_piece const& piece, double const sy) -> double
+{
+    double const y1 = piece.c.p1.y - sy;
+    double const y2 = piece.c.p2.y - sy;
+    double const y3 = piece.c.p3.y - sy;
+
+    double const a = y1 - 2.0 * y2 + y3;
+    double const b = y1 - y2;
+
+    double t = 0.0;
+
+    if(std::abs(a) < 1e-12) {
+        t = y1 / (2.0 * b);
+    }
+    else {
+        double const root = std::sqrt(std::max(b * b - a * y1, 0.0));
+        t = (b - root) / a;
+        if(t < 0.0 || t > 1.0) {
+            t = (b + root) / a;
+        }
+    }
+
+    t = std::clamp(t, 0.0, 1.0);
+    double const it = 1.0 - t;
+
+    return it * it * piece.c.p1.x + 2.0 * t * it * piece.c.p2.x + t * t * piece.c.p3.x;
+}
+
+} // namespace
+
+auto render_reference(std::vector<curve> const& curves,
+                      raster_params const& params,
+                      int const samples,
+                      std::vector<float>& coverage) -> void
+{
+    trace_span const span{ "reference", "quality", "samples", samples };
+
+    auto const pieces = monotone_pieces(curves);
+    std::vector<crossing> crossings;
+    std::vector<int> inside(static_cast<std::size_t>(params.width));
+
+    coverage.assign(static_cast<std::size_t>(params.width) * params.height, 0.0F);
+
+    double const step = 1.0 / (samples * static_cast<double>(params.scale));
+    double const norm = 1.0 / (static_cast<double>(samples) * samples);
+
+    for(int row = 0; row < params.height; ++row) {
+        double const center_y = params.min_y + static_cast<double>(params.height - 1 - row) / params.scale;
+
+        std::fill(inside.begin(), inside.end(), 0);
+
+        for(int sy_index = 0; sy_index < samples; ++sy_index) {
+            double const sy = center_y + (sy_index + 0.5 - 0.5 * samples) * step;
+
+            // Half-open spans count a shared endpoint of two pieces exactly once.
+            crossings.clear();
+            int winding = 0;
+
+            for(auto const& piece : pieces) {
+                if(sy >= piece.y_min && sy < piece.y_max) {
+                    crossings.push_back(crossing{ crossing_x(piece, sy), piece.dir });
+                    winding += piece.dir;
+                }
+            }
+
+            std::sort(crossings.begin(), crossings.end(), [](crossing const& l, crossing const& r) {
+                return l.x < r.x;
+            });
+
+            // `winding` sums the crossings right of the sample, i.e. those not yet passed.
+            auto next = crossings.begin();
+
+            for(int x = 0; x < params.width; ++x) {
+                double const center_x = params.min_x + static_cast<double>(x) / params.scale;
+
+                for(int sx_index = 0; sx_index < samples; ++sx_index) {
+                    double const sx = center_x + (sx_index + 0.5 - 0.5 * samples) * step;
+
+                    for(; next != crossings.end() && next->x <= sx; ++next) {
+                        winding -= next->dir;
+                    }
+
+                    inside[static_cast<std::size_t>(x)] += winding != 0 ? 1 : 0;
+                }
+            }
+        }
+
+        float* const line = coverage.data() + static_cast<std::size_t>(row) * params.width;
+
+        for(int x = 0; x < params.width; ++x) {
+            line[x] = static_cast<float>(inside[static_cast<std::size_t>(x)] * norm);
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef BEZIER_REFERENCE_HPP
+#define BEZIER_REFERENCE_HPP
+
+#include <vector>
+
+#include "raster.hpp"
+
+constexpr int default_reference_samples = 16;
+
+// Brute-force coverage to measure the fast renderers against: pixel (x, row) is the share of a
+// `samples` x `samples` grid of points inside the outline under the nonzero winding rule. The
+// pixel is the 1 / scale square centered on the point `render_rows` samples,
+// (min_x + x / scale, min_y + (height - 1 - row) / scale). `coverage` receives width * height
+// values in 0..1, top row first.
+auto render_reference(std::vector<curve> const& curves,
+                      raster_params const& params,
+                      int samples,
+                      std::vector<float>& coverage) -> void;
+
+#endif // BEZIER_REFERENCE_HPP
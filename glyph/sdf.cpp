@@ -0,0 +1,630 @@
+#include "sdf.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+
+#include "arena.hpp"
+#include "metrics.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+namespace {
+
+constexpr std::uint8_t red = 1;
+constexpr std::uint8_t green = 2;
+constexpr std::uint8_t blue = 4;
+constexpr std::uint8_t yellow = red | green;
+constexpr std::uint8_t magenta = red | blue;
+constexpr std::uint8_t cyan = green | blue;
+constexpr std::uint8_t white = red | green | blue;
+
+struct vec2
+{
+    double x;
+    double y;
+};
+
+auto operator+(vec2 const a, vec2 const b) -> vec2
+{
+    return vec2{ a.x + b.x, a.y + b.y };
+}
+
+auto operator-(vec2 const a, vec2 const b) -> vec2
+{
+    return vec2{ a.x - b.x, a.y - b.y };
+}
+
+auto operator*(double const s, vec2 const v) -> vec2
+{
+    return vec2{ s * v.x, s * v.y };
+}
+
+auto dot(vec2 const a, vec2 const b) -> double
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+auto cross(vec2 const a, vec2 const b) -> double
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+auto length(vec2 const v) -> double
+{
+    return std::sqrt(dot(v, v));
+}
+
+auto normalize(vec2 const v) -> vec2
+{
+    auto const len = length(v);
+    return len == 0.0 ? vec2{ 0.0, 1.0 } : vec2{ v.x / len, v.y / len };
+}
+
+auto to_vec2(point const p) -> vec2
+{
+    return vec2{ p.x, p.y };
+}
+
+auto non_zero_sign(double const v) -> double
+{
+    return v > 0.0 ? 1.0 : -1.0;
+}
+
+// Tangent at the start and end of a curve, falling back to the chord when the control point
+// coincides with that endpoint.
+auto start_direction(curve const& c) -> vec2
+{
+    auto const d = to_vec2(c.p2) - to_vec2(c.p1);
+    return (d.x == 0.0 && d.y == 0.0) ? to_vec2(c.p3) - to_vec2(c.p1) : d;
+}
+
+auto end_direction(curve const& c) -> vec2
+{
+    auto const d = to_vec2(c.p3) - to_vec2(c.p2);
+    return (d.x == 0.0 && d.y == 0.0) ? to_vec2(c.p3) - to_vec2(c.p1) : d;
+}
+
+auto solve_quadratic(std::array<double, 3>& x, double const a, double const b, double const c) -> int
+{
+    if(a == 0.0 || std::abs(b) > 1e12 * std::abs(a)) {
+        if(b == 0.0) {
+            return 0;
+        }
+        x[0] = -c / b;
+        return 1;
+    }
+
+    double const discriminant = b * b - 4.0 * a * c;
+
+    if(discriminant > 0.0) {
+        double const root = std::sqrt(discriminant);
+        x[0] = (-b + root) / (2.0 * a);
+        x[1] = (-b - root) / (2.0 * a);
+        return 2;
+    }
+    if(discriminant == 0.0) {
+        x[0] = -b / (2.0 * a);
+        return 1;
+    }
+    return 0;
+}
+
+// Roots of t^3 + a t^2 + b t + c.
+auto solve_cubic_normed(std::array<double, 3>& x, double a, double const b, double const c) -> int
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    double const a2 = a * a;
+    double q = (a2 - 3.0 * b) / 9.0;
+    double const r = (a * (2.0 * a2 - 9.0 * b) + 27.0 * c) / 54.0;
+    double const r2 = r * r;
+    double const q3 = q * q * q;
+
+    a /= 3.0;
+
+    if(r2 < q3) {
+        double const t = std::acos(std::clamp(r / std::sqrt(q3), -1.0, 1.0));
+        q = -2.0 * std::sqrt(q);
+        x[0] = q * std::cos(t / 3.0) - a;
+        x[1] = q * std::cos((t + 2.0 * pi) / 3.0) - a;
+        x[2] = q * std::cos((t - 2.0 * pi) / 3.0) - a;
+        return 3;
+    }
+
+    double const u = (r < 0.0 ? 1.0 : -1.0) * std::cbrt(std::abs(r) + std::sqrt(r2 - q3));
+    double const v = u == 0.0 ? 0.0 : q / u;
+    x[0] = (u + v) - a;
+
+    if(u == v || std::abs(u - v) < 1e-12 * std::abs(u + v)) {
+        x[1] = -0.5 * (u + v) - a;
+        return 2;
+    }
+    return 1;
+}
+
+auto solve_cubic(std::array<double, 3>& x, double const a, double const b, double const c, double const d) -> int
+{
+    if(a != 0.0) {
+        double const bn = b / a;
+        // Past this ratio treating the curve as a parabola is more accurate than dividing by a.
+        if(std::abs(bn) < 1e6) {
+            return solve_cubic_normed(x, bn, c / a, d / a);
+        }
+    }
+    return solve_quadratic(x, b, c, d);
+}
+
+// Signed distance from a point to one curve. `dot` breaks ties between curves meeting at a
+// shared endpoint: the one approached more orthogonally wins.
+struct signed_distance
+{
+    double distance = -std::numeric_limits<double>::max();
+    double dot = 1.0;
+};
+
+auto operator<(signed_distance const& a, signed_distance const& b) -> bool
+{
+    auto const da = std::abs(a.distance);
+    auto const db = std::abs(b.distance);
+    return da < db || (da == db && a.dot < b.dot);
+}
+
+auto curve_signed_distance(curve const& c, vec2 const origin, double& param) -> signed_distance
+{
+    auto const p0 = to_vec2(c.p1);
+    auto const p1 = to_vec2(c.p2);
+    auto const p2 = to_vec2(c.p3);
+
+    auto const qa = p0 - origin;
+    auto const ab = p1 - p0;
+    auto const br = p2 - p1 - ab;
+
+    std::array<double, 3> t{};
+    int const solutions =
+        solve_cubic(t, dot(br, br), 3.0 * dot(ab, br), 2.0 * dot(ab, ab) + dot(qa, br), dot(qa, ab));
+
+    auto dir = start_direction(c);
+    double min_distance = non_zero_sign(cross(dir, qa)) * length(qa);
+    param = -dot(qa, dir) / dot(dir, dir);
+
+    dir = end_direction(c);
+    double const end_distance = length(p2 - origin);
+    if(end_distance < std::abs(min_distance)) {
+        min_distance = non_zero_sign(cross(dir, p2 - origin)) * end_distance;
+        param = dot(origin - p1, dir) / dot(dir, dir);
+    }
+
+    for(int i = 0; i < solutions; ++i) {
+        if(t[i] > 0.0 && t[i] < 1.0) {
+            auto const qe = qa + 2.0 * t[i] * ab + (t[i] * t[i]) * br;
+            double const distance = length(qe);
+            if(distance <= std::abs(min_distance)) {
+                min_distance = non_zero_sign(cross(ab + t[i] * br, qe)) * distance;
+                param = t[i];
+            }
+        }
+    }
+
+    if(param >= 0.0 && param <= 1.0) {
+        return signed_distance{ min_distance, 0.0 };
+    }
+    if(param < 0.5) {
+        return signed_distance{ min_distance, std::abs(dot(normalize(start_direction(c)), normalize(qa))) };
+    }
+    return signed_distance{ min_distance, std::abs(dot(normalize(end_direction(c)), normalize(p2 - origin))) };
+}
+
+// Past the ends of a curve, the distance to its extended tangent is used instead, which keeps
+// the channels of an MSDF consistent around corners.
+auto to_pseudo_distance(curve const& c, signed_distance& distance, vec2 const origin, double const param) -> void
+{
+    if(param < 0.0) {
+        auto const dir = normalize(start_direction(c));
+        auto const aq = origin - to_vec2(c.p1);
+        if(dot(aq, dir) < 0.0) {
+            double const pseudo = cross(aq, dir);
+            if(std::abs(pseudo) <= std::abs(distance.distance)) {
+                distance.distance = pseudo;
+                distance.dot = 0.0;
+            }
+        }
+    }
+    else if(param > 1.0) {
+        auto const dir = normalize(end_direction(c));
+        auto const bq = origin - to_vec2(c.p3);
+        if(dot(bq, dir) > 0.0) {
+            double const pseudo = cross(bq, dir);
+            if(std::abs(pseudo) <= std::abs(distance.distance)) {
+                distance.distance = pseudo;
+                distance.dot = 0.0;
+            }
+        }
+    }
+}
+
+// Non-zero winding of a horizontal ray from (px, py) towards +x, using the same root selection
+// as trace_ray.
+auto winding_number(std::vector<curve> const& curves,
+                    std::uint32_t const* first,
+                    std::uint32_t const* last,
+                    float const px,
+                    float const py) -> int
+{
+    int winding = 0;
+
+    for(auto const* it = first; it != last; ++it) {
+        auto const& crv = curves[*it];
+
+        auto const y1 = crv.p1.y - py;
+        auto const y2 = crv.p2.y - py;
+        auto const y3 = crv.p3.y - py;
+
+        auto const num = ((y1 > 0.0F) ? 2 : 0) + ((y2 > 0.0F) ? 4 : 0) + ((y3 > 0.0F) ? 8 : 0);
+        auto const sh = 0x2E74 >> num;
+
+        if((sh & 3) == 0) {
+            continue;
+        }
+
+        auto const a = y1 - 2 * y2 + y3;
+        auto const b = y1 - y2;
+        auto const c = y1;
+
+        float t1 = 0.0F;
+        float t2 = 0.0F;
+
+        if(std::abs(a) < 0.0001F) {
+            t1 = t2 = c / (2.0F * b);
+        }
+        else {
+            float const root = std::sqrt(std::max(b * b - a * c, 0.0F));
+            t1 = (b - root) / a;
+            t2 = (b + root) / a;
+        }
+
+        auto const x1 = crv.p1.x - px;
+        auto const x2 = crv.p2.x - px;
+        auto const x3 = crv.p3.x - px;
+
+        if((sh & 1) != 0 && eval_curve(x1, x2, x3, t1) > 0.0F) {
+            ++winding;
+        }
+        if((sh & 2) != 0 && eval_curve(x1, x2, x3, t2) > 0.0F) {
+            --winding;
+        }
+    }
+
+    return winding;
+}
+
+// Compressed lists of curve indices: one per grid cell for distances (curves whose bounds,
+// grown by the half range, touch the cell) and one per grid row for the winding test (curves
+// whose vertical extent overlaps the row).
+struct curve_grid
+{
+    explicit curve_grid(std::pmr::memory_resource* const memory)
+        : cell_offsets{ memory }
+        , cell_curves{ memory }
+        , band_offsets{ memory }
+        , band_curves{ memory }
+    {
+    }
+
+    int cols = 0;
+    int rows = 0;
+    double cell = 1.0;
+    std::pmr::vector<std::uint32_t> cell_offsets;
+    std::pmr::vector<std::uint32_t> cell_curves;
+    std::pmr::vector<std::uint32_t> band_offsets;
+    std::pmr::vector<std::uint32_t> band_curves;
+};
+
+// Fills `grid`; its lists and the scratch used to build them come from the grid's allocator.
+auto build_grid(std::vector<curve> const& curves, distance_field_params const& params, curve_grid& grid) -> void
+{
+    auto* const memory = grid.cell_offsets.get_allocator().resource();
+
+    double const cell_px = std::max(8.0, static_cast<double>(params.range));
+    grid.cell = cell_px / params.scale;
+    grid.cols = std::max(1, static_cast<int>(std::ceil(params.width / cell_px)));
+    grid.rows = std::max(1, static_cast<int>(std::ceil(params.height / cell_px)));
+
+    double const margin = 0.5 * params.range / params.scale;
+
+    auto const cell_x = [&](double const x) {
+        return std::clamp(static_cast<int>(std::floor((x - params.min_x) / grid.cell)), 0, grid.cols - 1);
+    };
+    auto const cell_y = [&](double const y) {
+        return std::clamp(static_cast<int>(std::floor((y - params.min_y) / grid.cell)), 0, grid.rows - 1);
+    };
+
+    struct span
+    {
+        int x0;
+        int x1;
+        int y0;
+        int y1;
+        int band0;
+        int band1;
+    };
+
+    std::pmr::vector<span> spans{ memory };
+    spans.reserve(curves.size());
+
+    for(auto const& c : curves) {
+        double const lo_x = std::min({ c.p1.x, c.p2.x, c.p3.x });
+        double const hi_x = std::max({ c.p1.x, c.p2.x, c.p3.x });
+        double const lo_y = std::min({ c.p1.y, c.p2.y, c.p3.y });
+        double const hi_y = std::max({ c.p1.y, c.p2.y, c.p3.y });
+
+        spans.push_back(span{ cell_x(lo_x - margin),
+                              cell_x(hi_x + margin),
+                              cell_y(lo_y - margin),
+                              cell_y(hi_y + margin),
+                              cell_y(lo_y),
+                              cell_y(hi_y) });
+    }
+
+    auto const num_cells = static_cast<std::size_t>(grid.cols) * grid.rows;
+    grid.cell_offsets.assign(num_cells + 1, 0);
+    grid.band_offsets.assign(static_cast<std::size_t>(grid.rows) + 1, 0);
+
+    for(auto const& s : spans) {
+        for(int y = s.y0; y <= s.y1; ++y) {
+            for(int x = s.x0; x <= s.x1; ++x) {
+                ++grid.cell_offsets[static_cast<std::size_t>(y) * grid.cols + x + 1];
+            }
+        }
+        for(int y = s.band0; y <= s.band1; ++y) {
+            ++grid.band_offsets[static_cast<std::size_t>(y) + 1];
+        }
+    }
+
+    for(std::size_t i = 1; i < grid.cell_offsets.size(); ++i) {
+        grid.cell_offsets[i] += grid.cell_offsets[i - 1];
+    }
+    for(std::size_t i = 1; i < grid.band_offsets.size(); ++i) {
+        grid.band_offsets[i] += grid.band_offsets[i - 1];
+    }
+
+    grid.cell_curves.resize(grid.cell_offsets.back());
+    grid.band_curves.resize(grid.band_offsets.back());
+
+    std::pmr::vector<std::uint32_t> cell_fill{ grid.cell_offsets.begin(), grid.cell_offsets.end() - 1, memory };
+    std::pmr::vector<std::uint32_t> band_fill{ grid.band_offsets.begin(), grid.band_offsets.end() - 1, memory };
+
+    for(std::uint32_t i = 0; i < spans.size(); ++i) {
+        auto const& s = spans[i];
+        for(int y = s.y0; y <= s.y1; ++y) {
+            for(int x = s.x0; x <= s.x1; ++x) {
+                grid.cell_curves[cell_fill[static_cast<std::size_t>(y) * grid.cols + x]++] = i;
+            }
+        }
+        for(int y = s.band0; y <= s.band1; ++y) {
+            grid.band_curves[band_fill[y]++] = i;
+        }
+    }
+}
+
+auto is_corner(vec2 const a, vec2 const b) -> bool
+{
+    // Same threshold as msdfgen's default: anything turning by more than ~3 radians of
+    // "sharpness" (sin 3) or folding back counts as a corner.
+    constexpr double cross_threshold = 0.14112000806;
+
+    auto const an = normalize(a);
+    auto const bn = normalize(b);
+    return dot(an, bn) <= 0.0 || std::abs(cross(an, bn)) > cross_threshold;
+}
+
+// Assigns each curve a subset of the RGB channels so that the two edges meeting at every corner
+// never share all their channels. Contours are runs of curves where each one starts where the
+// previous one ended.
+auto color_edges(std::vector<curve> const& curves, std::pmr::vector<std::uint8_t>& colors) -> void
+{
+    colors.assign(curves.size(), white);
+    std::pmr::vector<std::size_t> corners{ colors.get_allocator() };
+
+    std::size_t first = 0;
+    while(first < curves.size()) {
+        std::size_t last = first + 1;
+        while(last < curves.size() && curves[last].p1.x == curves[last - 1].p3.x &&
+              curves[last].p1.y == curves[last - 1].p3.y) {
+            ++last;
+        }
+
+        auto const m = last - first;
+        corners.clear();
+
+        for(std::size_t i = 0; i < m; ++i) {
+            auto const& prev = curves[first + (i + m - 1) % m];
+            if(is_corner(end_direction(prev), start_direction(curves[first + i]))) {
+                corners.push_back(i);
+            }
+        }
+
+        if(corners.size() == 1) {
+            // A teardrop: split the contour into three runs around its only corner.
+            static std::array<std::uint8_t, 3> const runs = { magenta, white, yellow };
+            for(std::size_t i = 0; i < m; ++i) {
+                auto const k = m > 1 ? static_cast<int>(3.0 + 2.875 * i / (m - 1) - 1.4375 + 0.5) - 3 : 0;
+                colors[first + (corners[0] + i) % m] = runs[static_cast<std::size_t>(k + 1)];
+            }
+        }
+        else if(corners.size() > 1) {
+            static std::array<std::uint8_t, 3> const cycle = { cyan, magenta, yellow };
+            std::size_t color = 0;
+            std::size_t const initial = color;
+
+            for(std::size_t c = 0; c < corners.size(); ++c) {
+                if(c > 0) {
+                    color = (color + 1) % cycle.size();
+                    if(c + 1 == corners.size() && color == initial) {
+                        color = (color + 1) % cycle.size();
+                    }
+                }
+
+                auto const begin = corners[c];
+                auto const end = c + 1 < corners.size() ? corners[c + 1] : corners[0] + m;
+                for(auto i = begin; i < end; ++i) {
+                    colors[first + i % m] = cycle[color];
+                }
+            }
+        }
+
+        first = last;
+    }
+}
+
+// +1 when the outline's outer contours run clockwise (TrueType), -1 otherwise. Edge distances
+// are signed by which side of the edge the point is on, so this turns them into inside-positive.
+auto orientation_sign(std::vector<curve> const& curves) -> double
+{
+    double area = 0.0;
+    for(auto const& c : curves) {
+        area += cross(to_vec2(c.p1), to_vec2(c.p2)) + cross(to_vec2(c.p2), to_vec2(c.p3));
+    }
+    return area > 0.0 ? -1.0 : 1.0;
+}
+
+auto encode_distance(double const distance_px, float const range) -> std::uint8_t
+{
+    double const v = std::clamp(0.5 + distance_px / range, 0.0, 1.0);
+    return static_cast<std::uint8_t>(std::lround(v * 255.0));
+}
+
+auto median(double const a, double const b, double const c) -> double
+{
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+} // namespace
+
+auto parse_distance_field_type(std::string const& name, distance_field_type& type) -> bool
+{
+    if(name == "sdf") {
+        type = distance_field_type::sdf;
+    }
+    else if(name == "msdf") {
+        type = distance_field_type::msdf;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+auto render_distance_field(std::vector<curve> const& curves,
+                           distance_field_params const& params,
+                           std::uint8_t* const dst,
+                           std::size_t const stride) -> void
+{
+    if(params.width <= 0 || params.height <= 0) {
+        return;
+    }
+
+    // The grid and edge colors live in this thread's arena until the field is done.
+    arena_scope const scratch;
+    curve_grid grid{ scratch.resource() };
+    std::pmr::vector<std::uint8_t> colors{ scratch.resource() };
+    double orient = 1.0;
+
+    {
+        phase_timer const timer{ phase::preprocess };
+
+        build_grid(curves, params, grid);
+        if(params.type == distance_field_type::msdf) {
+            color_edges(curves, colors);
+        }
+        else {
+            colors.assign(curves.size(), white);
+        }
+        orient = orientation_sign(curves);
+    }
+
+    phase_timer const timer{ phase::raster };
+
+    int const channels = channel_count(params.type);
+
+    // Anything farther than this is clamped anyway.
+    double const far = params.range / params.scale;
+
+    parallel_for(static_cast<std::size_t>(params.height), params.threads, [&](std::size_t const r) {
+        trace_span const span{ "row", "distance_field", "row", static_cast<std::int64_t>(r) };
+
+        auto const row = static_cast<int>(r);
+        auto const fy = params.min_y + (params.height - row - 0.5F) / params.scale;
+        auto const gy = std::clamp(static_cast<int>(std::floor((fy - params.min_y) / grid.cell)), 0, grid.rows - 1);
+
+        std::uint8_t* const line = dst + r * stride;
+
+        auto const* band_first = grid.band_curves.data() + grid.band_offsets[gy];
+        auto const* band_last = grid.band_curves.data() + grid.band_offsets[gy + 1];
+
+        for(int x = 0; x < params.width; ++x) {
+            auto const fx = params.min_x + (x + 0.5F) / params.scale;
+            auto const gx =
+                std::clamp(static_cast<int>(std::floor((fx - params.min_x) / grid.cell)), 0, grid.cols - 1);
+            auto const cell = static_cast<std::size_t>(gy) * grid.cols + gx;
+
+            bool const inside = winding_number(curves, band_first, band_last, fx, fy) != 0;
+            double const outside_sign = inside ? 1.0 : -1.0;
+            vec2 const origin{ fx, fy };
+
+            std::array<signed_distance, 3> best{};
+            std::array<std::uint32_t, 3> best_curve{};
+            std::array<double, 3> best_param{};
+            std::array<bool, 3> found{};
+
+            for(auto i = grid.cell_offsets[cell]; i < grid.cell_offsets[cell + 1]; ++i) {
+                auto const index = grid.cell_curves[i];
+                double param = 0.0;
+                auto const d = curve_signed_distance(curves[index], origin, param);
+
+                for(int ch = 0; ch < 3; ++ch) {
+                    if((colors[index] & (1U << ch)) != 0 && (!found[ch] || d < best[ch])) {
+                        best[ch] = d;
+                        best_curve[ch] = index;
+                        best_param[ch] = param;
+                        found[ch] = true;
+                    }
+                }
+            }
+
+            if(params.type == distance_field_type::sdf) {
+                double const distance = found[0] ? std::min(std::abs(best[0].distance), far) : far;
+                line[x] = encode_distance(outside_sign * distance * params.scale, params.range);
+                continue;
+            }
+
+            std::array<double, 3> channel{};
+            for(int ch = 0; ch < 3; ++ch) {
+                if(!found[ch]) {
+                    channel[ch] = outside_sign * far;
+                    continue;
+                }
+                to_pseudo_distance(curves[best_curve[ch]], best[ch], origin, best_param[ch]);
+                channel[ch] = orient * best[ch].distance;
+            }
+
+            // A texel can be inside by winding yet have every nearby edge of one color behind it;
+            // keep the median on the side the winding test says.
+            if((median(channel[0], channel[1], channel[2]) > 0.0) != inside) {
+                for(auto& c : channel) {
+                    c = outside_sign * std::abs(c);
+                }
+            }
+
+            for(int ch = 0; ch < channels; ++ch) {
+                line[x * channels + ch] = encode_distance(channel[ch] * params.scale, params.range);
+            }
+        }
+    });
+    if(metrics_enabled()) {
+        add_count(counter::pixels_shaded, static_cast<std::uint64_t>(params.width) * params.height);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef BEZIER_SDF_HPP
+#define BEZIER_SDF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "raster.hpp"
+
+// `sdf` stores one true signed distance per texel. `msdf` colors the edges of every contour
+// and stores one signed pseudo-distance per color channel, so the median of the three
+// reconstructs sharp corners that a single channel would round off.
+enum class distance_field_type
+{
+    sdf,
+    msdf
+};
+
+[[nodiscard]] auto parse_distance_field_type(std::string const& name, distance_field_type& type) -> bool;
+
+[[nodiscard]] constexpr auto channel_count(distance_field_type const type) -> int
+{
+    return type == distance_field_type::sdf ? 1 : 3;
+}
+
+// Texel (x, row) samples the outline at (min_x + (x + 0.5) / scale, min_y + (height - row - 0.5) / scale).
+// Distances are measured in pixels and stored as 0.5 + d / range, clamped to [0, 1], with
+// the inside of the outline above 0.5.
+struct distance_field_params
+{
+    distance_field_type type = distance_field_type::sdf;
+    int width = 0;
+    int height = 0;
+    float min_x = 0.0F;
+    float min_y = 0.0F;
+    float scale = 1.0F;
+    float range = 4.0F;
+    unsigned threads = 0;
+};
+
+// Fills `dst` (rows of `stride` bytes) with the distance field of `curves`. Curves are bucketed
+// into a grid of cells so each texel only measures the curves that can lie within `range / 2`
+// of it, and rows are spread across worker threads. A field without curves is all outside; one
+// without texels is left alone.
+auto render_distance_field(std::vector<curve> const& curves,
+                           distance_field_params const& params,
+                           std::uint8_t* dst,
+                           std::size_t stride) -> void;
+
+#endif // BEZIER_SDF_HPP
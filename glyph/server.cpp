@@ -0,0 +1,560 @@
+#include "server.hpp"
+
+#include <spdlog/spdlog.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "encode.hpp"
+#include "metrics.hpp"
+#include "outline.hpp"
+#include "raster.hpp"
+#include "sdf.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+auto handle_stop_signal(int) -> void
+{
+    g_stop = 1;
+}
+
+[[nodiscard]] auto read_all(int const fd, void* data, std::size_t size) -> bool
+{
+    auto* bytes = static_cast<std::uint8_t*>(data);
+
+    while(size > 0) {
+        auto const n = ::read(fd, bytes, size);
+        if(n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+[[nodiscard]] auto write_all(int const fd, void const* data, std::size_t size) -> bool
+{
+    auto const* bytes = static_cast<std::uint8_t const*>(data);
+
+    while(size > 0) {
+        auto const n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if(n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+[[nodiscard]] auto make_address(std::string const& path, sockaddr_un& addr) -> bool
+{
+    addr = sockaddr_un{};
+    addr.sun_family = AF_UNIX;
+
+    if(path.size() >= sizeof(addr.sun_path)) {
+        spdlog::error("Socket path {} is too long!", path);
+        return false;
+    }
+
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// FT_Face is not thread-safe, so loading goes through the face's mutex; decomposed outlines are
+// immutable afterwards and shared by every job that needs them.
+struct font_entry
+{
+    FT_Face face = nullptr;
+    std::mutex mutex;
+    std::unordered_map<FT_UInt, std::shared_ptr<glyph_outline const>> outlines;
+};
+
+// The descriptor is closed when the last request holding the connection has been answered.
+struct connection
+{
+    explicit connection(int const fd_)
+        : fd{ fd_ }
+    {
+    }
+
+    connection(connection const&) = delete;
+    connection(connection&&) = delete;
+
+    ~connection()
+    {
+        ::close(fd);
+    }
+
+    auto operator=(connection const&) -> connection& = delete;
+    auto operator=(connection&&) -> connection& = delete;
+
+    int fd;
+    std::atomic<bool> closed{ false };
+};
+
+struct reader
+{
+    std::shared_ptr<connection> conn;
+    std::thread thread;
+};
+
+struct pending_request
+{
+    std::shared_ptr<connection> conn;
+    request_header header;
+    std::vector<std::uint32_t> glyphs;
+    std::vector<glyph_result> results;
+    render_status status = render_status::ok;
+};
+
+class render_server
+{
+public:
+    explicit render_server(server_options const& opts)
+        : m_opts{ opts }
+        , m_pool{ opts.threads }
+    {
+    }
+
+    render_server(render_server const&) = delete;
+    render_server(render_server&&) = delete;
+    ~render_server();
+
+    auto operator=(render_server const&) -> render_server& = delete;
+    auto operator=(render_server&&) -> render_server& = delete;
+
+    [[nodiscard]] auto load_fonts() -> bool;
+    [[nodiscard]] auto run() -> bool;
+
+private:
+    auto read_requests(std::shared_ptr<connection> conn) -> void;
+    auto dispatch() -> void;
+    auto render(pending_request& request, std::size_t index) -> void;
+    [[nodiscard]] auto get_outline(font_entry& font, std::uint32_t id, bool char_code)
+        -> std::shared_ptr<glyph_outline const>;
+    auto reply(pending_request const& request) -> void;
+
+    server_options m_opts;
+    thread_pool m_pool;
+
+    FT_Library m_library = nullptr;
+    std::vector<std::unique_ptr<font_entry>> m_fonts;
+
+    std::mutex m_queue_mutex;
+    std::condition_variable m_queue_ready;
+    std::deque<std::unique_ptr<pending_request>> m_queue;
+    std::atomic<bool> m_stopping{ false };
+
+    std::vector<reader> m_readers;
+};
+
+render_server::~render_server()
+{
+    for(auto& font : m_fonts) {
+        FT_Done_Face(font->face);
+    }
+    if(m_library != nullptr) {
+        FT_Done_FreeType(m_library);
+    }
+}
+
+auto render_server::load_fonts() -> bool
+{
+    if(FT_Init_FreeType(&m_library)) {
+        spdlog::error("Couldn't initialize Freetype!");
+        return false;
+    }
+
+    for(auto const& path : m_opts.font_paths) {
+        auto font = std::make_unique<font_entry>();
+        phase_timer const timer{ phase::font_open };
+
+        if(FT_New_Face(m_library, path.c_str(), 0, &font->face)) {
+            spdlog::error("Font file {} could not be read :(", path);
+            return false;
+        }
+
+        spdlog::info("Font #{}: {} ({} glyphs)", m_fonts.size(), path, font->face->num_glyphs);
+        m_fonts.push_back(std::move(font));
+    }
+
+    return true;
+}
+
+auto render_server::run() -> bool
+{
+    sockaddr_un addr{};
+    if(!make_address(m_opts.socket_path, addr)) {
+        return false;
+    }
+
+    int const listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_fd < 0) {
+        spdlog::error("Could not create socket!");
+        return false;
+    }
+
+    ::unlink(m_opts.socket_path.c_str());
+
+    if(::bind(listen_fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd, 64) != 0) {
+        spdlog::error("Could not listen on {}!", m_opts.socket_path);
+        ::close(listen_fd);
+        return false;
+    }
+
+    std::signal(SIGINT, handle_stop_signal);
+    std::signal(SIGTERM, handle_stop_signal);
+
+    spdlog::info("Listening on {} with {} workers", m_opts.socket_path, m_pool.size());
+
+    std::thread dispatcher{ [this]() { dispatch(); } };
+
+    while(g_stop == 0) {
+        pollfd pfd{ listen_fd, POLLIN, 0 };
+        if(::poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+
+        int const fd = ::accept(listen_fd, nullptr, nullptr);
+        if(fd < 0) {
+            continue;
+        }
+
+        auto const finished = std::partition(
+            m_readers.begin(), m_readers.end(), [](reader const& r) { return !r.conn->closed; });
+        for(auto it = finished; it != m_readers.end(); ++it) {
+            it->thread.join();
+        }
+        m_readers.erase(finished, m_readers.end());
+
+        auto conn = std::make_shared<connection>(fd);
+        m_readers.push_back(reader{ conn, std::thread{ [this, conn]() { read_requests(conn); } } });
+    }
+
+    spdlog::info("Shutting down");
+
+    ::close(listen_fd);
+    ::unlink(m_opts.socket_path.c_str());
+
+    for(auto& r : m_readers) {
+        ::shutdown(r.conn->fd, SHUT_RDWR);
+        r.thread.join();
+    }
+    m_readers.clear();
+
+    m_stopping = true;
+    m_queue_ready.notify_all();
+    dispatcher.join();
+
+    return true;
+}
+
+auto render_server::read_requests(std::shared_ptr<connection> conn) -> void
+{
+    while(true) {
+        auto request = std::make_unique<pending_request>();
+        request->conn = conn;
+
+        if(!read_all(conn->fd, &request->header, sizeof(request->header))) {
+            break;
+        }
+
+        if(request->header.magic != request_magic || request->header.glyph_count > max_glyphs_per_request) {
+            spdlog::error("Dropping connection after a malformed request");
+            ::shutdown(conn->fd, SHUT_RDWR);
+            break;
+        }
+
+        request->glyphs.resize(request->header.glyph_count);
+        if(!read_all(conn->fd, request->glyphs.data(), request->glyphs.size() * sizeof(std::uint32_t))) {
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{ m_queue_mutex };
+            m_queue.push_back(std::move(request));
+        }
+        m_queue_ready.notify_one();
+    }
+
+    conn->closed = true;
+}
+
+auto render_server::dispatch() -> void
+{
+    while(true) {
+        std::deque<std::unique_ptr<pending_request>> batch;
+
+        {
+            std::unique_lock<std::mutex> lock{ m_queue_mutex };
+            m_queue_ready.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+
+            if(m_queue.empty()) {
+                return;
+            }
+
+            // Give concurrent clients a moment to join this batch.
+            auto const deadline = std::chrono::steady_clock::now() + m_opts.batch_window;
+            m_queue_ready.wait_until(lock, deadline, [this]() { return m_stopping.load(); });
+
+            batch.swap(m_queue);
+        }
+
+        for(auto& request : batch) {
+            auto const& header = request->header;
+
+            if(header.font_id >= m_fonts.size()) {
+                request->status = render_status::unknown_font;
+                continue;
+            }
+            if(header.format > static_cast<std::uint32_t>(render_format::msdf) || !(header.size > 0.0F) ||
+               !(header.size <= max_request_size)) {
+                request->status = render_status::bad_request;
+                continue;
+            }
+
+            request->results.resize(request->glyphs.size());
+
+            for(std::size_t i = 0; i < request->glyphs.size(); ++i) {
+                m_pool.submit([this, req = request.get(), i]() { render(*req, i); });
+            }
+        }
+
+        m_pool.wait();
+
+        for(auto const& request : batch) {
+            reply(*request);
+        }
+    }
+}
+
+auto render_server::get_outline(font_entry& font, std::uint32_t const id, bool const char_code)
+    -> std::shared_ptr<glyph_outline const>
+{
+    std::lock_guard<std::mutex> lock{ font.mutex };
+
+    auto const index = char_code ? FT_Get_Char_Index(font.face, id) : static_cast<FT_UInt>(id);
+    auto const it = font.outlines.find(index);
+
+    if(it != font.outlines.end()) {
+        return it->second;
+    }
+
+    auto outline = std::make_shared<glyph_outline>();
+    if(!load_glyph_outline_by_index(font.face, index, *outline)) {
+        return nullptr;
+    }
+
+    font.outlines.emplace(index, outline);
+    return outline;
+}
+
+auto render_server::render(pending_request& request, std::size_t const index) -> void
+{
+    auto const& header = request.header;
+    auto& result = request.results[index];
+    auto& font = *m_fonts[header.font_id];
+
+    result.header.glyph_id = request.glyphs[index];
+    result.header.status = static_cast<std::uint32_t>(render_status::failed);
+
+    // This runs on a pool worker, where an escaping exception would terminate the server. Running
+    // out of memory fails this glyph only.
+    try {
+        auto const outline = get_outline(font, request.glyphs[index], (header.flags & request_flag_char_codes) != 0);
+        if(outline == nullptr) {
+            return;
+        }
+
+        float const scale = header.size / static_cast<float>(font.face->units_per_EM);
+        auto const format = static_cast<render_format>(header.format);
+
+        if(outline->curves.empty()) {
+            result.header.status = static_cast<std::uint32_t>(render_status::ok);
+            return;
+        }
+
+        auto const too_large = [&result](int const width, int const height) {
+            if(width > max_glyph_dimension || height > max_glyph_dimension) {
+                result.header.status = static_cast<std::uint32_t>(render_status::bad_request);
+                return true;
+            }
+            return false;
+        };
+
+        image_view image;
+        std::vector<std::uint8_t> pixels;
+
+        if(format == render_format::sdf || format == render_format::msdf) {
+            auto params = make_distance_field_params(*outline,
+                                                     scale,
+                                                     format == render_format::sdf ? distance_field_type::sdf
+                                                                                  : distance_field_type::msdf,
+                                                     m_opts.field_range);
+            params.threads = 1;
+
+            if(too_large(params.width, params.height)) {
+                return;
+            }
+
+            int const channels = channel_count(params.type);
+            auto const stride = static_cast<std::size_t>(params.width) * channels;
+            pixels.resize(stride * params.height);
+            render_distance_field(outline->curves, params, pixels.data(), stride);
+            image = image_view{ pixels.data(), params.width, params.height, channels, stride };
+        }
+        else {
+            bool const coverage = format == render_format::coverage || format == render_format::png_coverage;
+            auto const params =
+                make_raster_params(*outline, scale, coverage ? pixel_format::coverage : pixel_format::rgba);
+
+            if(too_large(params.width, params.height)) {
+                return;
+            }
+
+            image = render_image(outline->curves, params, pixels);
+        }
+
+        result.header.width = image.width;
+        result.header.height = image.height;
+        result.header.channels = static_cast<std::uint32_t>(image.channels);
+
+        if(format == render_format::png_coverage || format == render_format::png_rgba) {
+            if(!encode_png(image, result.data)) {
+                return;
+            }
+        }
+        else {
+            result.data = std::move(pixels);
+        }
+
+        result.header.byte_size = static_cast<std::uint32_t>(result.data.size());
+        result.header.status = static_cast<std::uint32_t>(render_status::ok);
+    }
+    catch(std::bad_alloc const&) {
+        spdlog::error("Out of memory rendering glyph {} at {} ppem", request.glyphs[index], header.size);
+        result = glyph_result{};
+        result.header.glyph_id = request.glyphs[index];
+        result.header.status = static_cast<std::uint32_t>(render_status::failed);
+    }
+}
+
+auto render_server::reply(pending_request const& request) -> void
+{
+    response_header header;
+    header.status = static_cast<std::uint32_t>(request.status);
+    header.glyph_count = static_cast<std::uint32_t>(request.results.size());
+
+    bool ok = write_all(request.conn->fd, &header, sizeof(header));
+
+    for(auto const& result : request.results) {
+        ok = ok && write_all(request.conn->fd, &result.header, sizeof(result.header)) &&
+             write_all(request.conn->fd, result.data.data(), result.data.size());
+    }
+
+    if(!ok) {
+        ::shutdown(request.conn->fd, SHUT_RDWR);
+    }
+}
+
+} // namespace
+
+auto run_server(server_options const& opts) -> bool
+{
+    render_server server{ opts };
+
+    return server.load_fonts() && server.run();
+}
+
+auto request_glyphs(std::string const& socket_path,
+                    request_header const& header,
+                    std::vector<std::uint32_t> const& glyphs,
+                    std::vector<glyph_result>& results) -> bool
+{
+    sockaddr_un addr{};
+    if(!make_address(socket_path, addr)) {
+        return false;
+    }
+
+    int const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || ::connect(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0) {
+        spdlog::error("Could not connect to {}!", socket_path);
+        if(fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    auto request = header;
+    request.glyph_count = static_cast<std::uint32_t>(glyphs.size());
+
+    response_header response;
+
+    bool ok = write_all(fd, &request, sizeof(request)) &&
+              write_all(fd, glyphs.data(), glyphs.size() * sizeof(std::uint32_t)) &&
+              read_all(fd, &response, sizeof(response)) && response.magic == response_magic;
+
+    if(ok && response.status != static_cast<std::uint32_t>(render_status::ok)) {
+        spdlog::error("Server rejected the request with status {}", response.status);
+        ok = false;
+    }
+
+    results.clear();
+    if(ok) {
+        results.resize(response.glyph_count);
+    }
+
+    for(auto& result : results) {
+        ok = ok && read_all(fd, &result.header, sizeof(result.header));
+        if(ok) {
+            result.data.resize(result.header.byte_size);
+            ok = read_all(fd, result.data.data(), result.data.size());
+        }
+    }
+
+    ::close(fd);
+    return ok;
+}
+
+#else
+
+auto run_server(server_options const&) -> bool
+{
+    spdlog::error("The render server needs Unix domain sockets!");
+    return false;
+}
+
+auto request_glyphs(std::string const&,
+                    request_header const&,
+                    std::vector<std::uint32_t> const&,
+                    std::vector<glyph_result>&) -> bool
+{
+    spdlog::error("The render server needs Unix domain sockets!");
+    return false;
+}
+
+#endif
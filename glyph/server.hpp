@@ -0,0 +1,95 @@
+#ifndef BEZIER_SERVER_HPP
+#define BEZIER_SERVER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Wire format of the render daemon. Everything is in host byte order since the socket is local.
+// A request is a `request_header` followed by `glyph_count` 32-bit glyph ids; the reply is a
+// `response_header` followed by, per glyph, a `glyph_header` and `byte_size` bytes of pixels.
+constexpr std::uint32_t request_magic = 0x51525A42;  // "BZRQ"
+constexpr std::uint32_t response_magic = 0x53525A42; // "BZRS"
+constexpr std::uint32_t max_glyphs_per_request = 1 << 16;
+
+// Larger sizes are a bad request; a glyph whose image would be wider or taller than
+// `max_glyph_dimension` pixels (a wide glyph near the size limit) gets `bad_request` on its own.
+constexpr float max_request_size = 4096.0F;
+constexpr std::int32_t max_glyph_dimension = 8192;
+
+// Set in `request_header::flags` when the ids are character codes rather than glyph indices.
+constexpr std::uint32_t request_flag_char_codes = 1;
+
+enum class render_format : std::uint32_t
+{
+    coverage = 0,
+    rgba = 1,
+    png_coverage = 2,
+    png_rgba = 3,
+    sdf = 4,
+    msdf = 5
+};
+
+enum class render_status : std::uint32_t
+{
+    ok = 0,
+    bad_request = 1,
+    unknown_font = 2,
+    failed = 3
+};
+
+struct request_header
+{
+    std::uint32_t magic = request_magic;
+    std::uint32_t font_id = 0;
+    std::uint32_t glyph_count = 0;
+    std::uint32_t format = 0;
+    std::uint32_t flags = 0;
+    float size = 0.0F; // pixels per em
+};
+
+struct response_header
+{
+    std::uint32_t magic = response_magic;
+    std::uint32_t status = 0;
+    std::uint32_t glyph_count = 0;
+};
+
+struct glyph_header
+{
+    std::uint32_t glyph_id = 0;
+    std::uint32_t status = 0;
+    std::int32_t width = 0;
+    std::int32_t height = 0;
+    std::uint32_t channels = 0;
+    std::uint32_t byte_size = 0;
+};
+
+struct glyph_result
+{
+    glyph_header header;
+    std::vector<std::uint8_t> data;
+};
+
+struct server_options
+{
+    std::string socket_path;
+    std::vector<std::string> font_paths; // font id = index in this list
+    unsigned threads = 0;
+    std::chrono::microseconds batch_window{ 2000 };
+    float field_range = 4.0F;
+};
+
+// Runs until SIGINT/SIGTERM. FreeType, the faces, decomposed outlines and the worker pool stay
+// alive across requests; requests arriving within `batch_window` of each other are scheduled
+// on the pool together.
+[[nodiscard]] auto run_server(server_options const& opts) -> bool;
+
+// Sends one request to a running server and waits for the reply.
+[[nodiscard]] auto request_glyphs(std::string const& socket_path,
+                                  request_header const& header,
+                                  std::vector<std::uint32_t> const& glyphs,
+                                  std::vector<glyph_result>& results) -> bool;
+
+#endif // BEZIER_SERVER_HPP
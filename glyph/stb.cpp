@@ -1,2 +1,7 @@
+#include "deflate.hpp"
+#include "png_stream.hpp"
+
+#define STBIW_ZLIB_COMPRESS parallel_zlib_compress
+#define STBIW_ESTIMATE_PNG_FILTER sampled_png_filter
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
@@ -31,6 +31,10 @@ BUILDING:
    unsigned char * my_compress(unsigned char *data, int data_len, int *out_len, int quality);
    The returned data will be freed with STBIW_FREE() (free() by default),
    so it must be heap allocated with STBIW_MALLOC() (malloc() by default),
+   You can #define STBIW_ESTIMATE_PNG_FILTER to enable stbi_write_png_filter_sample_step; it
+   picks the filter type (0-4) for a row and must have the following signature:
+   int my_estimate(const unsigned char *row, const unsigned char *prev, int len, int n, int step);
+   where `prev` is the row above (null for the first row) and `len` is the row's length in bytes.
 
 UNICODE:
 
@@ -68,6 +72,9 @@ stbi_write_jpg_to_func(stbi_write_func *func, void *context, int x, int y, int c
       int stbi_write_tga_with_rle;             // defaults to true; set to 0 to disable RLE
       int stbi_write_png_compression_level;    // defaults to 8; set to higher for more compression
       int stbi_write_force_png_filter;         // defaults to -1; set to 0..5 to force a filter mode
+      int stbi_write_png_filter_sample_step;   // defaults to 1; set to N > 1 to pick the adaptive filter
+                                               // from every Nth pixel of a row instead of all of them
+                                               // (needs STBIW_ESTIMATE_PNG_FILTER)
 
 
    You can define STBI_WRITE_NO_STDIO to disable the file variant of these
@@ -169,6 +176,7 @@ LICENSE
 extern int stbi_write_tga_with_rle;
 extern int stbi_write_png_compression_level;
 extern int stbi_write_force_png_filter;
+extern int stbi_write_png_filter_sample_step;
 #endif
 
 #ifndef STBI_WRITE_NO_STDIO
@@ -250,10 +258,12 @@ STBIWDEF void stbi_flip_vertically_on_write(int flip_boolean);
 static int stbi_write_png_compression_level = 8;
 static int stbi_write_tga_with_rle = 1;
 static int stbi_write_force_png_filter = -1;
+static int stbi_write_png_filter_sample_step = 1;
 #else
 int stbi_write_png_compression_level = 8;
 int stbi_write_tga_with_rle = 1;
 int stbi_write_force_png_filter = -1;
+int stbi_write_png_filter_sample_step = 1;
 #endif
 
 static int stbi__flip_vertically_on_write = 0;
@@ -1257,6 +1267,16 @@ static void stbiw__encode_png_line(unsigned char* pixels,
     }
 }
 
+#ifdef STBIW_ESTIMATE_PNG_FILTER
+// Cheap stand-in for running all five filters over the row, see STBIW_ESTIMATE_PNG_FILTER.
+static int stbiw__estimate_png_filter(unsigned char* pixels, int stride_bytes, int width, int height, int y, int n, int step)
+{
+    unsigned char* z = pixels + stride_bytes * (stbi__flip_vertically_on_write ? height - 1 - y : y);
+    int signed_stride = stbi__flip_vertically_on_write ? -stride_bytes : stride_bytes;
+    return STBIW_ESTIMATE_PNG_FILTER(z, y != 0 ? z - signed_stride : 0, width * n, n, step);
+}
+#endif
+
 STBIWDEF unsigned char*
 stbi_write_png_to_mem(const unsigned char* pixels, int stride_bytes, int x, int y, int n, int* out_len)
 {
@@ -1288,6 +1308,13 @@ stbi_write_png_to_mem(const unsigned char* pixels, int stride_bytes, int x, int
             filter_type = force_filter;
             stbiw__encode_png_line((unsigned char*)(pixels), stride_bytes, x, y, j, n, force_filter, line_buffer);
         }
+#ifdef STBIW_ESTIMATE_PNG_FILTER
+        else if(stbi_write_png_filter_sample_step > 1) {
+            filter_type = stbiw__estimate_png_filter(
+                (unsigned char*)(pixels), stride_bytes, x, y, j, n, stbi_write_png_filter_sample_step);
+            stbiw__encode_png_line((unsigned char*)(pixels), stride_bytes, x, y, j, n, filter_type, line_buffer);
+        }
+#endif
         else { // Estimate the best filter by running through all of them:
             int best_filter = 0, best_filter_val = 0x7fffffff, est, i;
             for(filter_type = 0; filter_type < 5; filter_type++) {
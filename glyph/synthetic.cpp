@@ -0,0 +1,204 @@
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr float two_pi = 6.2831853F;
+
+// splitmix64. The standard distributions are implementation-defined, so a generator that
+// promises the same random choices everywhere has to bring its own.
+class random_source
+{
+public:
+    explicit random_source(std::uint64_t const seed)
+        : m_state{ seed }
+    {
+    }
+
+    auto next() -> std::uint64_t
+    {
+        std::uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [lo, hi).
+    auto uniform(float const lo, float const hi) -> float
+    {
+        return lo + (hi - lo) * static_cast<float>(next() >> 40) / static_cast<float>(1U << 24);
+    }
+
+private:
+    std::uint64_t m_state;
+};
+
+auto add_curve(glyph_outline& outline, point const p1, point const p2, point const p3) -> void
+{
+    outline.curves.push_back(curve{ p1, p2, p3 });
+
+    for(auto const& p : { p1, p2, p3 }) {
+        outline.min_x = std::min(outline.min_x, p.x);
+        outline.min_y = std::min(outline.min_y, p.y);
+        outline.max_x = std::max(outline.max_x, p.x);
+        outline.max_y = std::max(outline.max_y, p.y);
+    }
+}
+
+auto clamp_point(point const p, float const extent) -> point
+{
+    return point{ std::clamp(p.x, 0.0F, extent), std::clamp(p.y, 0.0F, extent) };
+}
+
+// A closed ring of `count` quadratics around `center`. Vertices sit up to `jitter` (a fraction
+// of `radius`) inside it; every control point bulges off the chord by a random amount.
+auto add_ring(glyph_outline& outline,
+              random_source& rng,
+              synthetic_params const& params,
+              point const center,
+              float const radius,
+              float const jitter,
+              std::size_t const count,
+              bool const reversed) -> void
+{
+    float const step = two_pi / static_cast<float>(count);
+
+    std::vector<point> vertices(count);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        float const shuffle = params.self_intersection * rng.uniform(-1.0F, 1.0F);
+        float const angle = (static_cast<float>(i) + shuffle) * step * (reversed ? -1.0F : 1.0F);
+        float const r = radius * rng.uniform(1.0F - jitter, 1.0F);
+
+        vertices[i] =
+            clamp_point(point{ center.x + r * std::cos(angle), center.y + r * std::sin(angle) }, params.extent);
+    }
+
+    for(std::size_t i = 0; i < count; ++i) {
+        auto const a = vertices[i];
+        auto const b = vertices[(i + 1) % count];
+        float const bulge = rng.uniform(-0.3F, 0.3F);
+
+        point const control{ (a.x + b.x) / 2.0F - (b.y - a.y) * bulge, (a.y + b.y) / 2.0F + (b.x - a.x) * bulge };
+        add_curve(outline, a, clamp_point(control, params.extent), b);
+    }
+}
+
+// A long, gently curved band `thin_width` across: one side out along a chain of quadratics,
+// the other side back, joined by two short caps.
+auto add_sliver(glyph_outline& outline,
+                random_source& rng,
+                synthetic_params const& params,
+                point const center,
+                float const length,
+                std::size_t const count) -> void
+{
+    std::size_t const per_side = std::max<std::size_t>((count - 2) / 2, 1);
+    float const angle = rng.uniform(0.0F, two_pi);
+    float const bend = rng.uniform(-0.2F, 0.2F) * length;
+
+    point const along{ std::cos(angle), std::sin(angle) };
+    point const across{ -along.y, along.x };
+
+    auto const at = [&](float const t, float const side) {
+        float const u = t - 0.5F;
+        float const offset = bend * (1.0F - 4.0F * u * u) + side * params.thin_width / 2.0F;
+        point const position{ center.x + along.x * u * length + across.x * offset,
+                              center.y + along.y * u * length + across.y * offset };
+        return clamp_point(position, params.extent);
+    };
+
+    auto const side = [&](float const sign, bool const forward) {
+        for(std::size_t i = 0; i < per_side; ++i) {
+            float t0 = static_cast<float>(i) / per_side;
+            float t1 = static_cast<float>(i + 1) / per_side;
+            if(!forward) {
+                t0 = 1.0F - t0;
+                t1 = 1.0F - t1;
+            }
+            auto const a = at(t0, sign);
+            auto const b = at(t1, sign);
+            auto const m = at((t0 + t1) / 2.0F, sign);
+            // The control point that makes the quadratic pass through `m` at t = 0.5.
+            add_curve(outline, a, point{ 2.0F * m.x - (a.x + b.x) / 2.0F, 2.0F * m.y - (a.y + b.y) / 2.0F }, b);
+        }
+    };
+
+    auto const cap = [&](point const a, point const b) {
+        add_curve(outline, a, point{ (a.x + b.x) / 2.0F, (a.y + b.y) / 2.0F }, b);
+    };
+
+    side(1.0F, true);
+    cap(at(1.0F, 1.0F), at(1.0F, -1.0F));
+    side(-1.0F, false);
+    cap(at(0.0F, -1.0F), at(0.0F, 1.0F));
+}
+
+} // namespace
+
+auto parse_point_distribution(std::string const& name, point_distribution& distribution) -> bool
+{
+    if(name == "uniform") {
+        distribution = point_distribution::uniform;
+        return true;
+    }
+    if(name == "clustered") {
+        distribution = point_distribution::clustered;
+        return true;
+    }
+    return false;
+}
+
+auto generate_outline(synthetic_params const& params, glyph_outline& outline) -> void
+{
+    outline = glyph_outline{};
+
+    random_source rng{ params.seed };
+
+    int const contours = std::max(params.contours, 1);
+    int const nesting = std::max(params.nesting, 1);
+    auto const rings = static_cast<std::size_t>(contours) * nesting;
+    std::size_t const per_ring = std::max<std::size_t>(params.curves / rings, 3);
+
+    outline.curves.reserve(per_ring * rings + 4 * contours);
+
+    // Shapes get smaller as there are more of them, so they overlap only somewhat.
+    float const extent = params.extent;
+    float const radius = extent / (2.0F * std::sqrt(static_cast<float>(contours)));
+
+    constexpr int clusters = 3;
+    std::vector<point> cluster_centers;
+    for(int i = 0; i < clusters; ++i) {
+        cluster_centers.push_back(point{ rng.uniform(0.25F, 0.75F) * extent, rng.uniform(0.25F, 0.75F) * extent });
+    }
+
+    for(int c = 0; c < contours; ++c) {
+        point center{ extent / 2.0F, extent / 2.0F };
+
+        if(contours > 1 && params.distribution == point_distribution::uniform) {
+            center = point{ rng.uniform(radius, extent - radius), rng.uniform(radius, extent - radius) };
+        }
+        else if(contours > 1) {
+            auto const& cluster = cluster_centers[rng.next() % clusters];
+            float const spread = extent / 8.0F;
+            center = clamp_point(
+                point{ cluster.x + rng.uniform(-spread, spread), cluster.y + rng.uniform(-spread, spread) }, extent);
+        }
+
+        if(rng.uniform(0.0F, 1.0F) < params.thin_fraction) {
+            add_sliver(outline, rng, params, center, 2.0F * radius, per_ring * nesting);
+            continue;
+        }
+
+        // Jitter stays within half the gap between rings, so rings of one shape never touch.
+        float const gap = 1.0F / (nesting + 1);
+
+        for(int level = 0; level < nesting; ++level) {
+            float const r = radius * (1.0F - level * gap);
+            add_ring(outline, rng, params, center, r, std::min(0.25F, gap / 2.0F), per_ring, level % 2 == 1);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef BEZIER_SYNTHETIC_HPP
+#define BEZIER_SYNTHETIC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "outline.hpp"
+
+// Where contour centers go: spread over the whole square, or bunched into a few clusters so
+// some pixels see many more curves than others.
+enum class point_distribution
+{
+    uniform,
+    clustered
+};
+
+[[nodiscard]] auto parse_point_distribution(std::string const& name, point_distribution& distribution) -> bool;
+
+// Knobs for `generate_outline`. The same parameters make the same random choices on every
+// platform; the curves themselves can still differ in the last bits where C libraries disagree
+// on std::cos and std::sin.
+struct synthetic_params
+{
+    std::uint64_t seed = 1;
+    // Total number of curves, split evenly over all rings (at least 3 per ring).
+    std::size_t curves = 64;
+    // Separate closed shapes placed according to `distribution`.
+    int contours = 1;
+    // Rings per shape. Each ring sits inside the previous one and runs the other way, so the
+    // shape alternates between filled and hollow from the outside in.
+    int nesting = 1;
+    // 0 gives star-shaped rings that never cross themselves. Larger values shuffle the vertex
+    // angles by up to this many vertex steps, folding the ring over itself.
+    float self_intersection = 0.0F;
+    // Share of shapes drawn as slivers `thin_width` units across instead of rings.
+    float thin_fraction = 0.0F;
+    float thin_width = 2.0F;
+    point_distribution distribution = point_distribution::uniform;
+    // The outline fits in [0, extent] on both axes.
+    float extent = 1000.0F;
+};
+
+// Fills `outline` with closed quadratic contours (bounds included) built from `params`.
+auto generate_outline(synthetic_params const& params, glyph_outline& outline) -> void;
+
+#endif // BEZIER_SYNTHETIC_HPP
@@ -0,0 +1,495 @@
+// Image-regression and performance-golden checks for the CPU renderer.
+//
+//   BezierTests golden <golden dir> <img_aa.png> [--update]
+//   BezierTests perf <baseline file> <tolerance percent> [--update]
+//
+// `golden` renders the top-level scene and a few test outlines and compares them against the
+// stored PNGs with a per-channel tolerance, and checks that an empty outline (a space) renders to
+// an empty image and distance field. On a mismatch it writes `<case>.actual.png` and
+// `<case>.diff.png` to the working directory. `--update` rewrites the goldens instead (the
+// scene reference is never rewritten; it is the output of the original renderer).
+//
+// `perf` times each case (best of several runs) and fails when one is more than the tolerance
+// slower than the baseline. A missing baseline, or `--update`, records the current timings.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include "encode.hpp"
+#include "outline.hpp"
+#include "raster.hpp"
+#include "sdf.hpp"
+#include "synthetic.hpp"
+
+namespace {
+
+// Largest per-channel difference that still counts as a match. Float evaluation order may
+// differ between compilers and flags; anything beyond rounding is a real change.
+constexpr int channel_tolerance = 1;
+
+// Each timing is the best of `perf_runs` samples; a sample repeats the render until it has run
+// for at least `perf_sample_time`, so tiny cases are not lost in timer and scheduler noise.
+constexpr int perf_runs = 5;
+constexpr std::chrono::milliseconds perf_sample_time{ 20 };
+
+struct test_case
+{
+    std::string name;
+    std::vector<curve> curves;
+    raster_params params;
+};
+
+struct decoded_image
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<std::uint8_t> pixels;
+};
+
+// The curves of the top-level main.cpp, a two-curve lens and a rectangle, in a unit square.
+auto scene_curves() -> std::vector<curve>
+{
+    return {
+        { { 0.3F, 0.3F }, { 0.5F, 0.5F }, { 0.3F, 0.7F } },     { { 0.3F, 0.7F }, { 1.0F, 0.5F }, { 0.3F, 0.3F } },
+        { { 0.9F, 0.3F }, { 0.9F, 0.5F }, { 0.9F, 0.7F } },     { { 0.9F, 0.7F }, { 0.93F, 0.7F }, { 0.95F, 0.7F } },
+        { { 0.95F, 0.7F }, { 0.95F, 0.5F }, { 0.95F, 0.3F } }, { { 0.95F, 0.3F }, { 0.93F, 0.3F }, { 0.9F, 0.3F } },
+    };
+}
+
+// A circle of eight quadratic arcs; `clockwise` flips the direction so it can cut a hole. The
+// arcs start off-axis: a segment endpoint exactly on a sample row is a known weak spot of the
+// renderer, which this case is not meant to pin down.
+auto add_circle(std::vector<curve>& curves, float const cx, float const cy, float const r, bool const clockwise)
+    -> void
+{
+    constexpr int segments = 8;
+    constexpr float step = 6.2831853F / segments;
+    float const control_radius = r / std::cos(step / 2.0F);
+    constexpr float start = 0.1F;
+    float const dir = clockwise ? -1.0F : 1.0F;
+
+    for(int i = 0; i < segments; ++i) {
+        float const a0 = start + dir * step * i;
+        float const a1 = start + dir * step * (i + 1);
+        float const am = (a0 + a1) / 2.0F;
+
+        curves.push_back(curve{ point{ cx + r * std::cos(a0), cy + r * std::sin(a0) },
+                                point{ cx + control_radius * std::cos(am), cy + control_radius * std::sin(am) },
+                                point{ cx + r * std::cos(a1), cy + r * std::sin(a1) } });
+    }
+}
+
+auto add_line(std::vector<curve>& curves, point const a, point const b) -> void
+{
+    curves.push_back(curve{ a, point{ (a.x + b.x) / 2.0F, (a.y + b.y) / 2.0F }, b });
+}
+
+auto scene_case() -> test_case
+{
+    return test_case{ "scene", scene_curves(), raster_params{ 1600, 1600, 0.0F, 0.0F, 1600.0F, pixel_format::rgba } };
+}
+
+// Outlines in font-unit-like coordinates, sized and offset the way make_raster_params would.
+auto glyph_cases() -> std::vector<test_case>
+{
+    std::vector<test_case> cases;
+
+    test_case ring{ "ring", {}, raster_params{ 256, 256, 0.0F, 0.0F, 0.25F, pixel_format::coverage } };
+    add_circle(ring.curves, 512.0F, 512.0F, 450.0F, false);
+    add_circle(ring.curves, 512.0F, 512.0F, 280.0F, true);
+    cases.push_back(ring);
+
+    test_case triangle{ "triangle", {}, raster_params{ 97, 61, -40.0F, 12.0F, 0.1F, pixel_format::coverage } };
+    add_line(triangle.curves, point{ -30.0F, 20.0F }, point{ 900.0F, 40.0F });
+    add_line(triangle.curves, point{ 900.0F, 40.0F }, point{ 300.0F, 600.0F });
+    add_line(triangle.curves, point{ 300.0F, 600.0F }, point{ -30.0F, 20.0F });
+    cases.push_back(triangle);
+
+    test_case small_scene{ "scene_small", scene_curves(), raster_params{ 240, 160, 0.2F, 0.2F, 300.0F } };
+    cases.push_back(small_scene);
+
+    // Nested, folded and sliver contours from the scaling-study generator.
+    synthetic_params shape;
+    shape.seed = 7;
+    shape.curves = 96;
+    shape.contours = 3;
+    shape.nesting = 2;
+    shape.self_intersection = 0.5F;
+    shape.thin_fraction = 0.34F;
+    shape.distribution = point_distribution::clustered;
+
+    glyph_outline outline;
+    generate_outline(shape, outline);
+
+    raster_params const grid{ 256, 256, 0.0F, 0.0F, 0.256F, pixel_format::coverage };
+    test_case synthetic{ "synthetic", outline.curves, grid };
+    cases.push_back(synthetic);
+
+    return cases;
+}
+
+auto render(test_case const& tc) -> decoded_image
+{
+    decoded_image out;
+    auto const view = render_image(tc.curves, tc.params, out.pixels);
+    out.width = view.width;
+    out.height = view.height;
+    out.channels = view.channels;
+    return out;
+}
+
+auto paeth(int const a, int const b, int const c) -> int
+{
+    int const p = a + b - c;
+    int const pa = std::abs(p - a);
+    int const pb = std::abs(p - b);
+    int const pc = std::abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+}
+
+// Enough of a PNG decoder for the files this repo writes: 8-bit, non-interlaced gray, gray-alpha,
+// rgb or rgba.
+auto decode_png(std::string const& filename, decoded_image& image) -> bool
+{
+    std::ifstream file{ filename, std::ios::binary };
+    std::vector<std::uint8_t> const data{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+    auto const be32 = [&](std::size_t const at) {
+        return static_cast<std::uint32_t>(data[at]) << 24 | static_cast<std::uint32_t>(data[at + 1]) << 16 |
+               static_cast<std::uint32_t>(data[at + 2]) << 8 | static_cast<std::uint32_t>(data[at + 3]);
+    };
+
+    if(data.size() < 8 || data[1] != 'P' || data[2] != 'N' || data[3] != 'G') {
+        spdlog::error("{} is not a PNG file", filename);
+        return false;
+    }
+
+    std::vector<std::uint8_t> idat;
+    std::size_t pos = 8;
+
+    while(pos + 12 <= data.size()) {
+        auto const length = be32(pos);
+        std::string const type(data.begin() + pos + 4, data.begin() + pos + 8);
+        auto const body = pos + 8;
+
+        if(body + length + 4 > data.size()) {
+            break;
+        }
+
+        if(type == "IHDR") {
+            image.width = static_cast<int>(be32(body));
+            image.height = static_cast<int>(be32(body + 4));
+
+            int const color_type = data[body + 9];
+            image.channels = color_type == 0 ? 1 : color_type == 4 ? 2 : color_type == 2 ? 3 : 4;
+
+            if(data[body + 8] != 8 || color_type == 3 || data[body + 12] != 0) {
+                spdlog::error("{}: only 8-bit non-interlaced PNGs are supported", filename);
+                return false;
+            }
+        }
+        else if(type == "IDAT") {
+            idat.insert(idat.end(), data.begin() + body, data.begin() + body + length);
+        }
+        pos = body + length + 4;
+    }
+
+    auto const stride = static_cast<std::size_t>(image.width) * image.channels;
+    std::vector<std::uint8_t> raw((stride + 1) * image.height);
+    auto raw_size = static_cast<uLongf>(raw.size());
+
+    if(uncompress(raw.data(), &raw_size, idat.data(), static_cast<uLong>(idat.size())) != Z_OK ||
+       raw_size != raw.size()) {
+        spdlog::error("{}: corrupt image data", filename);
+        return false;
+    }
+
+    image.pixels.assign(stride * image.height, 0);
+
+    for(int y = 0; y < image.height; ++y) {
+        auto const filter = raw[y * (stride + 1)];
+        auto const* in = raw.data() + y * (stride + 1) + 1;
+        auto* line = image.pixels.data() + y * stride;
+        auto const* prev = y > 0 ? line - stride : nullptr;
+
+        for(std::size_t i = 0; i < stride; ++i) {
+            int const a = i >= static_cast<std::size_t>(image.channels) ? line[i - image.channels] : 0;
+            int const b = prev != nullptr ? prev[i] : 0;
+            int const c =
+                prev != nullptr && i >= static_cast<std::size_t>(image.channels) ? prev[i - image.channels] : 0;
+            int const predictor = filter == 1   ? a
+                                  : filter == 2 ? b
+                                  : filter == 3 ? (a + b) / 2
+                                  : filter == 4 ? paeth(a, b, c)
+                                                : 0;
+            line[i] = static_cast<std::uint8_t>(in[i] + predictor);
+        }
+    }
+
+    return true;
+}
+
+auto save_png(std::string const& filename, decoded_image const& image) -> bool
+{
+    std::vector<std::uint8_t> encoded;
+    image_view const view{ image.pixels.data(),
+                           image.width,
+                           image.height,
+                           image.channels,
+                           static_cast<std::size_t>(image.width) * image.channels };
+
+    return encode_png(view, encoded) && write_file(filename.c_str(), encoded);
+}
+
+auto flip_rows(decoded_image& image) -> void
+{
+    auto const stride = static_cast<std::size_t>(image.width) * image.channels;
+    for(int top = 0, bottom = image.height - 1; top < bottom; ++top, --bottom) {
+        std::swap_ranges(image.pixels.begin() + top * stride,
+                         image.pixels.begin() + (top + 1) * stride,
+                         image.pixels.begin() + bottom * stride);
+    }
+}
+
+auto compare(std::string const& name, decoded_image const& actual, decoded_image const& expected) -> bool
+{
+    if(actual.width != expected.width || actual.height != expected.height || actual.channels != expected.channels) {
+        spdlog::error("{}: rendered {}x{}x{}, golden is {}x{}x{}",
+                      name,
+                      actual.width,
+                      actual.height,
+                      actual.channels,
+                      expected.width,
+                      expected.height,
+                      expected.channels);
+        return false;
+    }
+
+    decoded_image diff{ actual.width, actual.height, 1, {} };
+    diff.pixels.resize(static_cast<std::size_t>(actual.width) * actual.height);
+
+    std::size_t mismatched = 0;
+    int worst = 0;
+
+    for(std::size_t p = 0; p < diff.pixels.size(); ++p) {
+        int delta = 0;
+        for(int ch = 0; ch < actual.channels; ++ch) {
+            auto const i = p * actual.channels + ch;
+            delta = std::max(delta, std::abs(actual.pixels[i] - expected.pixels[i]));
+        }
+        worst = std::max(worst, delta);
+        mismatched += delta > channel_tolerance ? 1 : 0;
+        diff.pixels[p] = static_cast<std::uint8_t>(std::min(delta * 16, 255));
+    }
+
+    if(mismatched > 0) {
+        spdlog::error("{}: {} pixels differ by more than {} (worst {}), see {}.diff.png",
+                      name,
+                      mismatched,
+                      channel_tolerance,
+                      worst,
+                      name);
+        static_cast<void>(save_png(name + ".actual.png", actual));
+        static_cast<void>(save_png(name + ".diff.png", diff));
+        return false;
+    }
+
+    spdlog::info("{}: ok (worst channel difference {})", name, worst);
+    return true;
+}
+
+// A space loads as an outline without curves. Both of its sizes are 0x0 and render nothing; a
+// fixed-size field cell without curves, as in an atlas, is all outside.
+auto check_empty_glyph() -> bool
+{
+    glyph_outline const space;
+    bool ok = true;
+
+    auto const raster = make_raster_params(space, 0.05F, pixel_format::coverage);
+    std::vector<std::uint8_t> pixels;
+    auto const image = render_image(space.curves, raster, pixels);
+
+    if(image.width != 0 || image.height != 0 || !pixels.empty()) {
+        spdlog::error("space: raster is {}x{}, expected 0x0", image.width, image.height);
+        ok = false;
+    }
+
+    auto const field = make_distance_field_params(space, 0.05F, distance_field_type::sdf, 4.0F);
+    render_distance_field(space.curves, field, nullptr, 0);
+
+    if(field.width != 0 || field.height != 0) {
+        spdlog::error("space: distance field is {}x{}, expected 0x0", field.width, field.height);
+        ok = false;
+    }
+
+    distance_field_params cell;
+    cell.width = 8;
+    cell.height = 8;
+    cell.scale = 0.05F;
+    std::vector<std::uint8_t> texels(64, 0xFF);
+    render_distance_field(space.curves, cell, texels.data(), 8);
+
+    if(std::any_of(texels.begin(), texels.end(), [](std::uint8_t const t) { return t != 0; })) {
+        spdlog::error("space: an atlas cell without curves is not all outside");
+        ok = false;
+    }
+
+    if(ok) {
+        spdlog::info("space: ok");
+    }
+    return ok;
+}
+
+auto run_golden(std::string const& golden_dir, std::string const& scene_reference, bool const update) -> bool
+{
+    bool ok = true;
+
+    // The renderer numbers rows top-down with y pointing up; the original scene wrote row y at
+    // sample y, so its image is upside down relative to ours.
+    {
+        auto const tc = scene_case();
+        auto actual = render(tc);
+        decoded_image expected;
+
+        flip_rows(actual);
+        ok = decode_png(scene_reference, expected) && compare(tc.name, actual, expected);
+    }
+
+    for(auto const& tc : glyph_cases()) {
+        auto const actual = render(tc);
+        auto const path = golden_dir + "/" + tc.name + ".png";
+
+        if(update) {
+            ok = save_png(path, actual) && ok;
+            spdlog::info("{}: golden written to {}", tc.name, path);
+            continue;
+        }
+
+        decoded_image expected;
+        ok = decode_png(path, expected) && compare(tc.name, actual, expected) && ok;
+    }
+
+    return check_empty_glyph() && ok;
+}
+
+auto time_case(test_case const& tc) -> double
+{
+    using clock = std::chrono::steady_clock;
+
+    std::vector<std::uint8_t> pixels;
+    double best = 0.0;
+
+    for(int run = 0; run < perf_runs; ++run) {
+        auto const start = clock::now();
+        auto elapsed = clock::duration::zero();
+        int renders = 0;
+
+        do {
+            static_cast<void>(render_image(tc.curves, tc.params, pixels));
+            ++renders;
+            elapsed = clock::now() - start;
+        } while(elapsed < perf_sample_time);
+
+        double const ms = std::chrono::duration<double, std::milli>(elapsed).count() / renders;
+        best = run == 0 ? ms : std::min(best, ms);
+    }
+
+    return best;
+}
+
+auto run_perf(std::string const& baseline_path, double const tolerance, bool update) -> bool
+{
+    std::map<std::string, double> baseline;
+    {
+        std::ifstream in{ baseline_path };
+        std::string name;
+        double ms = 0.0;
+        while(in >> name >> ms) {
+            baseline[name] = ms;
+        }
+    }
+
+    update = update || baseline.empty();
+
+    auto cases = glyph_cases();
+    cases.insert(cases.begin(), scene_case());
+
+    bool ok = true;
+    std::ostringstream current;
+
+    for(auto const& tc : cases) {
+        double const ms = time_case(tc);
+        current << tc.name << ' ' << ms << '\n';
+
+        auto const it = baseline.find(tc.name);
+
+        if(update || it == baseline.end()) {
+            spdlog::info("{}: {:.3f} ms", tc.name, ms);
+            continue;
+        }
+
+        double const change = 100.0 * (ms / it->second - 1.0);
+        bool const regressed = change > tolerance;
+
+        if(regressed) {
+            spdlog::error("{}: {:.3f} ms, {:+.1f}% against the {:.3f} ms baseline (limit {}%)",
+                          tc.name,
+                          ms,
+                          change,
+                          it->second,
+                          tolerance);
+        }
+        else {
+            spdlog::info("{}: {:.3f} ms, {:+.1f}% against the {:.3f} ms baseline", tc.name, ms, change, it->second);
+        }
+        ok = ok && !regressed;
+    }
+
+    std::ofstream{ baseline_path + ".last" } << current.str();
+
+    if(update) {
+        std::ofstream{ baseline_path } << current.str();
+        spdlog::info("Baseline recorded in {}", baseline_path);
+    }
+
+    return ok;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    bool const update = std::find(args.begin(), args.end(), "--update") != args.end();
+    args.erase(std::remove(args.begin(), args.end(), "--update"), args.end());
+
+    if(args.size() == 3 && args[0] == "golden") {
+        return run_golden(args[1], args[2], update) ? 0 : 1;
+    }
+
+    if(args.size() == 3 && args[0] == "perf") {
+        char* end = nullptr;
+        double const tolerance = std::strtod(args[2].c_str(), &end);
+
+        if(*end == '\0' && tolerance >= 0.0) {
+            return run_perf(args[1], tolerance, update) ? 0 : 1;
+        }
+    }
+
+    spdlog::error("Usage: {} golden <golden dir> <scene reference png> [--update]", argv[0]);
+    spdlog::error("       {} perf <baseline file> <tolerance percent> [--update]", argv[0]);
+    return 2;
+}
@@ -0,0 +1,71 @@
+#include "thread_pool.hpp"
+
+#include "parallel.hpp"
+
+thread_pool::thread_pool(unsigned const threads)
+{
+    auto const n = worker_count(threads);
+
+    m_workers.reserve(n);
+    for(unsigned i = 0; i < n; ++i) {
+        m_workers.emplace_back([this]() { work(); });
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_stopping = true;
+    }
+    m_job_ready.notify_all();
+
+    for(auto& w : m_workers) {
+        w.join();
+    }
+}
+
+auto thread_pool::submit(std::function<void()> job) -> void
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_jobs.push_back(std::move(job));
+    }
+    m_job_ready.notify_one();
+}
+
+auto thread_pool::wait() -> void
+{
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    m_idle.wait(lock, [this]() { return m_jobs.empty() && m_running == 0; });
+}
+
+auto thread_pool::work() -> void
+{
+    while(true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_job_ready.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+            if(m_jobs.empty()) {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            ++m_running;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            --m_running;
+            if(m_jobs.empty() && m_running == 0) {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef BEZIER_THREAD_POOL_HPP
+#define BEZIER_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of long-lived workers. Unlike `parallel_for`, which spins threads up per call, the
+// pool stays warm between batches, which is what a long-running process wants.
+class thread_pool
+{
+public:
+    explicit thread_pool(unsigned threads = 0);
+    thread_pool(thread_pool const&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    ~thread_pool();
+
+    auto operator=(thread_pool const&) -> thread_pool& = delete;
+    auto operator=(thread_pool&&) -> thread_pool& = delete;
+
+    auto submit(std::function<void()> job) -> void;
+
+    // Blocks until every job submitted so far has finished.
+    auto wait() -> void;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return m_workers.size();
+    }
+
+private:
+    auto work() -> void;
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_job_ready;
+    std::condition_variable m_idle;
+    std::size_t m_running = 0;
+    bool m_stopping = false;
+};
+
+#endif // BEZIER_THREAD_POOL_HPP
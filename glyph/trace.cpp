@@ -0,0 +1,198 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace detail {
+bool g_tracing_enabled = false;
+} // namespace detail
+
+namespace {
+
+struct trace_event
+{
+    char const* name;
+    char const* category;
+    char const* arg_name;
+    std::int64_t arg;
+    std::int64_t start_ns;
+    std::int64_t duration_ns;
+};
+
+// Holds room for `trace_ring_size` events from the start, so recording never reallocates; once
+// full it wraps around.
+struct thread_buffer
+{
+    unsigned tid = 0;
+    std::string name;
+    std::vector<trace_event> events;
+    std::size_t recorded = 0;
+    bool in_use = false;
+};
+
+// Buffers stay alive after their thread exits so its events can still be written. The next
+// new thread takes over a released, unnamed buffer, so `parallel_for`, which starts fresh
+// threads on every call, shows up as a fixed set of tracks instead of one per call. Named
+// tracks belong to one thread.
+std::mutex g_registry_mutex;
+std::vector<std::unique_ptr<thread_buffer>> g_registry;
+
+struct buffer_handle
+{
+    buffer_handle() = default;
+    buffer_handle(buffer_handle const&) = delete;
+    buffer_handle(buffer_handle&&) = delete;
+
+    ~buffer_handle()
+    {
+        if(buffer != nullptr) {
+            std::lock_guard<std::mutex> lock{ g_registry_mutex };
+            buffer->in_use = false;
+        }
+    }
+
+    auto operator=(buffer_handle const&) -> buffer_handle& = delete;
+    auto operator=(buffer_handle&&) -> buffer_handle& = delete;
+
+    thread_buffer* buffer = nullptr;
+};
+
+thread_local buffer_handle t_handle;
+
+auto const g_epoch = std::chrono::steady_clock::now();
+
+auto local_buffer() -> thread_buffer&
+{
+    if(t_handle.buffer == nullptr) {
+        std::lock_guard<std::mutex> lock{ g_registry_mutex };
+
+        auto const released = std::find_if(g_registry.begin(), g_registry.end(), [](auto const& buffer) {
+            return !buffer->in_use && buffer->name.empty();
+        });
+
+        if(released != g_registry.end()) {
+            t_handle.buffer = released->get();
+        }
+        else {
+            g_registry.push_back(std::make_unique<thread_buffer>());
+            t_handle.buffer = g_registry.back().get();
+            t_handle.buffer->tid = static_cast<unsigned>(g_registry.size());
+            t_handle.buffer->events.reserve(trace_ring_size);
+        }
+
+        t_handle.buffer->in_use = true;
+    }
+    return *t_handle.buffer;
+}
+
+// The strings are literals from this code base, but escape the two characters that would
+// break the JSON anyway.
+auto write_escaped(std::FILE* file, char const* s) -> void
+{
+    for(; *s != '\0'; ++s) {
+        if(*s == '"' || *s == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(*s, file);
+    }
+}
+
+} // namespace
+
+auto enable_tracing(bool const enabled) -> void
+{
+    detail::g_tracing_enabled = enabled;
+}
+
+auto set_trace_thread_name(char const* name) -> void
+{
+    if(tracing_enabled()) {
+        local_buffer().name = name;
+    }
+}
+
+auto detail::trace_now() noexcept -> std::int64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+auto detail::record_span(char const* name,
+                         char const* category,
+                         std::int64_t const start_ns,
+                         std::int64_t const end_ns,
+                         char const* arg_name,
+                         std::int64_t const arg) -> void
+{
+    auto& buffer = local_buffer();
+    trace_event const event{ name, category, arg_name, arg, start_ns, end_ns - start_ns };
+
+    if(buffer.events.size() < trace_ring_size) {
+        buffer.events.push_back(event);
+    }
+    else {
+        buffer.events[buffer.recorded % trace_ring_size] = event;
+    }
+    ++buffer.recorded;
+}
+
+auto write_trace_json(char const* filename) -> bool
+{
+    std::FILE* file = std::fopen(filename, "wb");
+
+    if(file == nullptr) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock{ g_registry_mutex };
+    bool first = true;
+
+    std::fputs("{\"traceEvents\": [\n", file);
+
+    for(auto const& buffer : g_registry) {
+        if(!buffer->name.empty()) {
+            std::fprintf(file,
+                         "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+                         "\"args\": {\"name\": \"",
+                         first ? "" : ",\n",
+                         buffer->tid);
+            write_escaped(file, buffer->name.c_str());
+            std::fputs("\"}}", file);
+            first = false;
+        }
+
+        auto const count = std::min(buffer->recorded, trace_ring_size);
+
+        for(auto i = buffer->recorded - count; i < buffer->recorded; ++i) {
+            auto const& e = buffer->events[i % trace_ring_size];
+
+            std::fputs(first ? "{\"name\": \"" : ",\n{\"name\": \"", file);
+            write_escaped(file, e.name);
+            std::fputs("\", \"cat\": \"", file);
+            write_escaped(file, e.category);
+            std::fprintf(file,
+                         "\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f",
+                         buffer->tid,
+                         static_cast<double>(e.start_ns) * 1e-3,
+                         static_cast<double>(e.duration_ns) * 1e-3);
+
+            if(e.arg_name != nullptr) {
+                std::fputs(", \"args\": {\"", file);
+                write_escaped(file, e.arg_name);
+                std::fprintf(file, "\": %" PRId64 "}", e.arg);
+            }
+
+            std::fputc('}', file);
+            first = false;
+        }
+    }
+
+    std::fputs("\n]}\n", file);
+
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,82 @@
+#ifndef BEZIER_TRACE_HPP
+#define BEZIER_TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Timeline recording in Chrome's trace-event format (chrome://tracing, ui.perfetto.dev). Each
+// thread appends complete events to its own ring buffer without locking; the buffers are only
+// read by `write_trace_json`, once recording threads are done. A full ring overwrites its oldest
+// events, so a long run keeps its most recent `trace_ring_size` spans per thread.
+//
+// Names and categories must outlive the trace; string literals are what this is meant for.
+
+constexpr std::size_t trace_ring_size = std::size_t{ 1 } << 16;
+
+namespace detail {
+extern bool g_tracing_enabled;
+} // namespace detail
+
+[[nodiscard]] inline auto tracing_enabled() noexcept -> bool
+{
+    return detail::g_tracing_enabled;
+}
+
+// Not synchronized with running work: call it before any spans are recorded.
+auto enable_tracing(bool enabled = true) -> void;
+
+// Names the calling thread's track in the viewer. The name is copied.
+auto set_trace_thread_name(char const* name) -> void;
+
+// Must not race with threads still recording.
+[[nodiscard]] auto write_trace_json(char const* filename) -> bool;
+
+namespace detail {
+[[nodiscard]] auto trace_now() noexcept -> std::int64_t;
+auto record_span(char const* name,
+                 char const* category,
+                 std::int64_t start_ns,
+                 std::int64_t end_ns,
+                 char const* arg_name,
+                 std::int64_t arg) -> void;
+} // namespace detail
+
+// Records the lifetime of the object as one span on the calling thread. `arg_name`, when given,
+// shows up with `arg` in the span's details (e.g. the character code of a glyph).
+class trace_span
+{
+public:
+    explicit trace_span(char const* name,
+                        char const* category = "render",
+                        char const* arg_name = nullptr,
+                        std::int64_t const arg = 0) noexcept
+        : m_name{ name }
+        , m_category{ category }
+        , m_arg_name{ arg_name }
+        , m_arg{ arg }
+        , m_start{ tracing_enabled() ? detail::trace_now() : -1 }
+    {
+    }
+
+    trace_span(trace_span const&) = delete;
+    trace_span(trace_span&&) = delete;
+
+    ~trace_span()
+    {
+        if(m_start >= 0) {
+            detail::record_span(m_name, m_category, m_start, detail::trace_now(), m_arg_name, m_arg);
+        }
+    }
+
+    auto operator=(trace_span const&) -> trace_span& = delete;
+    auto operator=(trace_span&&) -> trace_span& = delete;
+
+private:
+    char const* m_name;
+    char const* m_category;
+    char const* m_arg_name;
+    std::int64_t m_arg;
+    std::int64_t m_start;
+};
+
+#endif // BEZIER_TRACE_HPP
@@ -0,0 +1,24 @@
+#include "frame_state.hpp"
+
+#include "glyph_shader.hpp"
+
+auto frame_state::create() -> bool
+{
+    m_buffer.create();
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer.get());
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(frame_uniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frame_state_binding, m_buffer.get());
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+auto frame_state::update(frame_uniforms const& uniforms) const -> void
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer.get());
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frame_uniforms), &uniforms);
+}
+
+auto frame_state::release() noexcept -> void
+{
+    m_buffer.reset();
+}
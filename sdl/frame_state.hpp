@@ -0,0 +1,38 @@
+#ifndef BEZIER_SDL_FRAME_STATE_HPP
+#define BEZIER_SDL_FRAME_STATE_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gl_handle.hpp"
+
+// Mirrors the std140 `frame_state` block of the glyph shaders: per-view and per-frame values
+// every glyph program shares. The viewport turns projected positions into pixels, which the
+// vertex shader needs for its one-pixel dilation.
+struct frame_uniforms
+{
+    glm::mat4 projection{ 1.0F };
+    glm::mat4 model{ 1.0F };
+    glm::vec2 viewport{ 1.0F, 1.0F };
+    glm::vec2 padding{ 0.0F, 0.0F };
+};
+
+static_assert(sizeof(frame_uniforms) == 144, "frame_uniforms must match the std140 frame_state block");
+
+// The uniform buffer behind `frame_state`, bound once to `frame_state_binding`. One update per
+// frame replaces a glUniform call per value and program.
+class frame_state
+{
+public:
+    // Creates the buffer and binds it.
+    [[nodiscard]] auto create() -> bool;
+
+    auto update(frame_uniforms const& uniforms) const -> void;
+
+    auto release() noexcept -> void;
+
+private:
+    gl_buffer m_buffer;
+};
+
+#endif // BEZIER_SDL_FRAME_STATE_HPP
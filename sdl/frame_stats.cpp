@@ -0,0 +1,152 @@
+#include "frame_stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+auto gpu_query::create(GLenum const target) -> bool
+{
+    release();
+
+    m_target = target;
+    for(auto& query : m_queries) {
+        query.create();
+    }
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+auto gpu_query::begin() -> void
+{
+    m_active = m_queries[0].get() != 0 && m_pending < depth;
+
+    if(m_active) {
+        glBeginQuery(m_target, m_queries[m_next].get());
+    }
+}
+
+auto gpu_query::end() -> void
+{
+    if(!m_active) {
+        return;
+    }
+
+    glEndQuery(m_target);
+    m_next = (m_next + 1) % depth;
+    ++m_pending;
+    m_active = false;
+}
+
+auto gpu_query::poll(std::uint64_t& value) -> bool
+{
+    if(m_pending == 0) {
+        return false;
+    }
+
+    auto const oldest = m_queries[(m_next + depth - m_pending) % depth].get();
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if(available == GL_FALSE) {
+        return false;
+    }
+
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(oldest, GL_QUERY_RESULT, &result);
+    value = result;
+    --m_pending;
+    return true;
+}
+
+auto gpu_query::release() noexcept -> void
+{
+    for(auto& query : m_queries) {
+        query.reset();
+    }
+    m_next = 0;
+    m_pending = 0;
+    m_active = false;
+}
+
+auto frame_history::add(double const value) -> void
+{
+    m_values[m_next] = value;
+    m_next = (m_next + 1) % capacity;
+    m_count = std::min(m_count + 1, capacity);
+}
+
+auto frame_history::mean() const -> double
+{
+    if(m_count == 0) {
+        return 0.0;
+    }
+    return std::accumulate(m_values.begin(), m_values.begin() + m_count, 0.0) / static_cast<double>(m_count);
+}
+
+auto frame_history::max() const -> double
+{
+    if(m_count == 0) {
+        return 0.0;
+    }
+    return *std::max_element(m_values.begin(), m_values.begin() + m_count);
+}
+
+auto frame_history::percentile(double const p) const -> double
+{
+    if(m_count == 0) {
+        return 0.0;
+    }
+
+    std::vector<double> sorted(m_values.begin(), m_values.begin() + m_count);
+    // The smallest value with at least `p` of the samples at or below it: rank ceil(p * n), counted
+    // from 1.
+    auto const position = std::ceil(p * static_cast<double>(m_count));
+    auto const rank = std::min(static_cast<std::size_t>(std::max(position, 1.0)) - 1, m_count - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+auto frame_history::buckets() const -> std::array<std::size_t, bucket_limits.size() + 1>
+{
+    std::array<std::size_t, bucket_limits.size() + 1> counts{};
+
+    for(std::size_t i = 0; i < m_count; ++i) {
+        auto const bucket = std::upper_bound(bucket_limits.begin(), bucket_limits.end(), m_values[i]);
+        ++counts[static_cast<std::size_t>(bucket - bucket_limits.begin())];
+    }
+    return counts;
+}
+
+auto log_frame_times(char const* name, frame_history const& history) -> void
+{
+    if(history.count() == 0) {
+        spdlog::info("{}: no samples", name);
+        return;
+    }
+
+    std::string bars;
+    auto const counts = history.buckets();
+
+    for(std::size_t i = 0; i < counts.size(); ++i) {
+        if(i < frame_history::bucket_limits.size()) {
+            bars += fmt::format(" <{}:{}", frame_history::bucket_limits[i], counts[i]);
+        }
+        else {
+            bars += fmt::format(" >={}:{}", frame_history::bucket_limits.back(), counts[i]);
+        }
+    }
+
+    spdlog::info("{}: {} frames, mean {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, max {:.3f} ms |{}",
+                 name,
+                 history.count(),
+                 history.mean(),
+                 history.percentile(0.5),
+                 history.percentile(0.95),
+                 history.max(),
+                 bars);
+}
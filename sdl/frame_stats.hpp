@@ -0,0 +1,76 @@
+#ifndef BEZIER_SDL_FRAME_STATS_HPP
+#define BEZIER_SDL_FRAME_STATS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "gl_handle.hpp"
+
+// One GL query per frame (GL_TIME_ELAPSED, GL_SAMPLES_PASSED, ...) read back a few frames
+// late, so asking for a result never waits for the GPU. A frame that would need a fifth query
+// in flight is simply not measured.
+//
+//     query.begin();  ... draw ...  query.end();
+//     while(query.poll(value)) { ... }
+class gpu_query
+{
+public:
+    static constexpr std::size_t depth = 4;
+
+    // Creates the query objects for `target`.
+    [[nodiscard]] auto create(GLenum target) -> bool;
+
+    auto begin() -> void;
+    auto end() -> void;
+
+    // The result of the oldest query in flight, if the GPU has finished it. After glFinish
+    // every query is finished, so polling until false collects them all.
+    [[nodiscard]] auto poll(std::uint64_t& value) -> bool;
+
+    auto release() noexcept -> void;
+
+private:
+    GLenum m_target = GL_TIME_ELAPSED;
+    std::array<gl_query, depth> m_queries;
+    std::size_t m_next = 0;
+    std::size_t m_pending = 0;
+    bool m_active = false;
+};
+
+// The last `capacity` values of one per-frame measurement, oldest overwritten first.
+class frame_history
+{
+public:
+    static constexpr std::size_t capacity = 240;
+
+    // Upper bounds of the millisecond buckets in `log_frame_times`; the last one is open.
+    static constexpr std::array<double, 7> bucket_limits = { 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 33.0 };
+
+    auto add(double value) -> void;
+
+    [[nodiscard]] auto count() const noexcept -> std::size_t
+    {
+        return m_count;
+    }
+
+    [[nodiscard]] auto mean() const -> double;
+    [[nodiscard]] auto max() const -> double;
+
+    // `p` in 0..1, nearest rank. 0 without samples.
+    [[nodiscard]] auto percentile(double p) const -> double;
+
+    [[nodiscard]] auto buckets() const -> std::array<std::size_t, bucket_limits.size() + 1>;
+
+private:
+    std::array<double, capacity> m_values{};
+    std::size_t m_next = 0;
+    std::size_t m_count = 0;
+};
+
+// Logs mean, median, p95 and max of millisecond samples and how they fall into the buckets.
+auto log_frame_times(char const* name, frame_history const& history) -> void;
+
+#endif // BEZIER_SDL_FRAME_STATS_HPP
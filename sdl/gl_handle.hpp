@@ -0,0 +1,186 @@
+#ifndef BEZIER_SDL_GL_HANDLE_HPP
+#define BEZIER_SDL_GL_HANDLE_HPP
+
+#include <utility>
+
+#include <glad/glad.h>
+
+// Owns one GL object and deletes it when reset, replaced or destroyed, so classes made of
+// handles need no destructor and cannot be copied by accident. GL objects belong to the context
+// that made them: create them while it is current and reset them (an owner's `release`) before
+// it goes away, since a handle that outlives its context would delete names in whatever context
+// is current then.
+//
+// `Kind` supplies `name_type`, `destroy(name)` and, where GL generates the name, `generate()`.
+template<typename Kind>
+class gl_handle
+{
+public:
+    using name_type = typename Kind::name_type;
+
+    gl_handle() = default;
+
+    explicit gl_handle(name_type const name) noexcept
+        : m_name{ name }
+    {
+    }
+
+    gl_handle(gl_handle const&) = delete;
+
+    gl_handle(gl_handle&& other) noexcept
+        : m_name{ std::exchange(other.m_name, name_type{}) }
+    {
+    }
+
+    ~gl_handle()
+    {
+        reset();
+    }
+
+    auto operator=(gl_handle const&) -> gl_handle& = delete;
+
+    auto operator=(gl_handle&& other) noexcept -> gl_handle&
+    {
+        reset(std::exchange(other.m_name, name_type{}));
+        return *this;
+    }
+
+    // Replaces the object with a newly generated one.
+    auto create() -> void
+    {
+        reset(Kind::generate());
+    }
+
+    auto reset(name_type const name = name_type{}) noexcept -> void
+    {
+        if(m_name != name_type{}) {
+            Kind::destroy(m_name);
+        }
+        m_name = name;
+    }
+
+    [[nodiscard]] auto get() const noexcept -> name_type
+    {
+        return m_name;
+    }
+
+private:
+    name_type m_name{};
+};
+
+struct gl_buffer_kind
+{
+    using name_type = GLuint;
+
+    static auto generate() -> GLuint
+    {
+        GLuint name = 0;
+        glGenBuffers(1, &name);
+        return name;
+    }
+
+    static auto destroy(GLuint const name) noexcept -> void
+    {
+        glDeleteBuffers(1, &name);
+    }
+};
+
+struct gl_texture_kind
+{
+    using name_type = GLuint;
+
+    static auto generate() -> GLuint
+    {
+        GLuint name = 0;
+        glGenTextures(1, &name);
+        return name;
+    }
+
+    static auto destroy(GLuint const name) noexcept -> void
+    {
+        glDeleteTextures(1, &name);
+    }
+};
+
+struct gl_framebuffer_kind
+{
+    using name_type = GLuint;
+
+    static auto generate() -> GLuint
+    {
+        GLuint name = 0;
+        glGenFramebuffers(1, &name);
+        return name;
+    }
+
+    static auto destroy(GLuint const name) noexcept -> void
+    {
+        glDeleteFramebuffers(1, &name);
+    }
+};
+
+struct gl_renderbuffer_kind
+{
+    using name_type = GLuint;
+
+    static auto generate() -> GLuint
+    {
+        GLuint name = 0;
+        glGenRenderbuffers(1, &name);
+        return name;
+    }
+
+    static auto destroy(GLuint const name) noexcept -> void
+    {
+        glDeleteRenderbuffers(1, &name);
+    }
+};
+
+struct gl_query_kind
+{
+    using name_type = GLuint;
+
+    static auto generate() -> GLuint
+    {
+        GLuint name = 0;
+        glGenQueries(1, &name);
+        return name;
+    }
+
+    static auto destroy(GLuint const name) noexcept -> void
+    {
+        glDeleteQueries(1, &name);
+    }
+};
+
+// Programs come from `create_program`; the handle only deletes them.
+struct gl_program_kind
+{
+    using name_type = GLuint;
+
+    static auto destroy(GLuint const name) noexcept -> void
+    {
+        glDeleteProgram(name);
+    }
+};
+
+// Fences come from glFenceSync; the handle only deletes them.
+struct gl_sync_kind
+{
+    using name_type = GLsync;
+
+    static auto destroy(GLsync const sync) noexcept -> void
+    {
+        glDeleteSync(sync);
+    }
+};
+
+using gl_buffer = gl_handle<gl_buffer_kind>;
+using gl_texture = gl_handle<gl_texture_kind>;
+using gl_framebuffer = gl_handle<gl_framebuffer_kind>;
+using gl_renderbuffer = gl_handle<gl_renderbuffer_kind>;
+using gl_query = gl_handle<gl_query_kind>;
+using gl_program = gl_handle<gl_program_kind>;
+using gl_sync = gl_handle<gl_sync_kind>;
+
+#endif // BEZIER_SDL_GL_HANDLE_HPP
@@ -0,0 +1,65 @@
+#include "gl_program.hpp"
+
+#include <spdlog/spdlog.h>
+
+auto create_shader(std::string const& source, unsigned int const type) -> unsigned int
+{
+    unsigned int shader = glCreateShader(type);
+
+    char const* src = source.c_str();
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+
+    int succeded = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &succeded);
+
+    if(succeded != GL_TRUE) {
+        int len = 0;
+        std::string msg;
+
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
+        msg.resize(static_cast<std::size_t>(len));
+        glGetShaderInfoLog(shader, static_cast<int>(msg.size()), nullptr, msg.data());
+
+        std::string const shader_type = (type == GL_VERTEX_SHADER ? "vertex" : "fragment");
+        spdlog::error("Compilation of {} shader failed: {}", shader_type, msg);
+    }
+
+    return shader;
+}
+
+auto create_program(program_description const& desc) -> unsigned int
+{
+    unsigned int program = glCreateProgram();
+
+    auto const vs = create_shader(desc.vertex_shader_source, GL_VERTEX_SHADER);
+    auto const fs = create_shader(desc.fragment_shader_source, GL_FRAGMENT_SHADER);
+
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+
+    if(desc.retrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    glLinkProgram(program);
+
+    int succeded = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &succeded);
+
+    if(succeded != GL_TRUE) {
+        int len = 0;
+        std::string msg;
+
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
+        msg.resize(static_cast<std::size_t>(len));
+        glGetProgramInfoLog(program, static_cast<int>(msg.size()), nullptr, msg.data());
+
+        spdlog::error("Program could not be linked: {}", msg);
+    }
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    return program;
+}
@@ -0,0 +1,20 @@
+#ifndef BEZIER_SDL_GL_PROGRAM_HPP
+#define BEZIER_SDL_GL_PROGRAM_HPP
+
+#include <string>
+
+#include <glad/glad.h>
+
+struct program_description
+{
+    std::string vertex_shader_source;
+    std::string fragment_shader_source;
+    // Ask the driver to keep the linked binary around for glGetProgramBinary.
+    bool retrievable = false;
+};
+
+[[nodiscard]] auto create_shader(std::string const& source, unsigned int type) -> unsigned int;
+
+[[nodiscard]] auto create_program(program_description const& desc) -> unsigned int;
+
+#endif // BEZIER_SDL_GL_PROGRAM_HPP
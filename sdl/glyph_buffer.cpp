@@ -0,0 +1,222 @@
+#include "glyph_buffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+#include "outline.hpp"
+
+namespace {
+
+auto float_bits(float const f) -> std::uint32_t
+{
+    std::uint32_t bits = 0;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// Creates an immutable-size buffer texture of `format` over `data`.
+[[nodiscard]] auto create_buffer_texture(void const* data,
+                                         std::size_t const bytes,
+                                         GLenum const format,
+                                         gl_buffer& buffer,
+                                         gl_texture& texture) -> bool
+{
+    buffer.create();
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer.get());
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(bytes), data, GL_STATIC_DRAW);
+
+    texture.create();
+    glBindTexture(GL_TEXTURE_BUFFER, texture.get());
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer.get());
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+} // namespace
+
+auto glyph_buffer::add(std::vector<curve> const& curves, float const advance) -> std::uint32_t
+{
+    glyph_entry e;
+    e.advance = advance;
+    e.first = static_cast<std::uint32_t>(curve_count());
+    e.min = point{ 1e30F, 1e30F };
+    e.max = point{ -1e30F, -1e30F };
+
+    for(auto const& c : curves) {
+        if(c.p1.x == c.p2.x && c.p2.x == c.p3.x && c.p1.y == c.p2.y && c.p2.y == c.p3.y) {
+            continue;
+        }
+
+        m_texels.insert(m_texels.end(), { c.p1.x, c.p1.y, c.p2.x, c.p2.y, c.p3.x, c.p3.y, 0.0F, 0.0F });
+
+        for(auto const& p : { c.p1, c.p2, c.p3 }) {
+            e.min = point{ std::min(e.min.x, p.x), std::min(e.min.y, p.y) };
+            e.max = point{ std::max(e.max.x, p.x), std::max(e.max.y, p.y) };
+        }
+        ++e.count;
+    }
+
+    if(e.count == 0) {
+        e.min = e.max = point{ 0.0F, 0.0F };
+    }
+
+    add_bands(e);
+
+    m_entries.push_back(e);
+    return static_cast<std::uint32_t>(m_entries.size() - 1);
+}
+
+auto glyph_buffer::add_bands(glyph_entry& e) -> void
+{
+    e.bands = e.count == 0 ? 0
+                           : std::clamp(static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(e.count)))),
+                                        1U,
+                                        max_glyph_bands);
+    e.band_base = static_cast<std::uint32_t>(band_texel_count());
+
+    auto const texel =
+        [this](std::uint32_t const x, std::uint32_t const y, std::uint32_t const z, std::uint32_t const w) {
+            m_bands.insert(m_bands.end(), { x, y, z, w });
+        };
+
+    texel(float_bits(e.min.x), float_bits(e.min.y), float_bits(e.max.x), float_bits(e.max.y));
+    texel(e.bands, e.first, e.count, 0);
+
+    auto const headers = m_bands.size();
+    m_bands.resize(headers + 4 * 2 * static_cast<std::size_t>(e.bands), 0);
+
+    std::vector<std::uint32_t> members;
+
+    // Axis 0 cuts horizontal strips along y and sorts by x; axis 1 the other way round.
+    for(int axis = 0; axis < 2; ++axis) {
+        float const lo = axis == 0 ? e.min.y : e.min.x;
+        float const hi = axis == 0 ? e.max.y : e.max.x;
+        float const size = std::max(hi - lo, 1e-6F) / static_cast<float>(e.bands);
+
+        auto const across = [axis](point const p) { return axis == 0 ? p.y : p.x; };
+        auto const along = [axis](point const p) { return axis == 0 ? p.x : p.y; };
+        auto const curve_at = [this](std::uint32_t const i) {
+            float const* t = m_texels.data() + 8 * static_cast<std::size_t>(i);
+            return curve{ { t[0], t[1] }, { t[2], t[3] }, { t[4], t[5] } };
+        };
+        auto const reach = [&](std::uint32_t const i) {
+            auto const c = curve_at(i);
+            return std::max({ along(c.p1), along(c.p2), along(c.p3) });
+        };
+
+        for(std::uint32_t b = 0; b < e.bands; ++b) {
+            // A hair of overlap so a curve ending exactly on a strip edge lands in both strips.
+            float const band_lo = lo + size * static_cast<float>(b) - size * 1e-3F;
+            float const band_hi = lo + size * static_cast<float>(b + 1) + size * 1e-3F;
+
+            members.clear();
+            for(std::uint32_t i = e.first; i < e.first + e.count; ++i) {
+                auto const c = curve_at(i);
+                float const c_lo = std::min({ across(c.p1), across(c.p2), across(c.p3) });
+                float const c_hi = std::max({ across(c.p1), across(c.p2), across(c.p3) });
+
+                if(c_hi >= band_lo && c_lo <= band_hi) {
+                    members.push_back(i);
+                }
+            }
+
+            std::stable_sort(members.begin(), members.end(), [&](std::uint32_t const l, std::uint32_t const r) {
+                return reach(l) > reach(r);
+            });
+
+            auto const header = headers + 4 * (static_cast<std::size_t>(axis) * e.bands + b);
+            m_bands[header] = static_cast<std::uint32_t>(band_texel_count());
+            m_bands[header + 1] = static_cast<std::uint32_t>(members.size());
+
+            m_bands.insert(m_bands.end(), members.begin(), members.end());
+            m_bands.resize((m_bands.size() + 3) / 4 * 4, 0);
+        }
+    }
+}
+
+auto glyph_buffer::add_font(FT_Face face, std::uint32_t& first_id) -> bool
+{
+    first_id = static_cast<std::uint32_t>(m_entries.size());
+
+    float const em = 1.0F / static_cast<float>(face->units_per_EM);
+    glyph_outline outline;
+
+    for(FT_Long index = 0; index < face->num_glyphs; ++index) {
+        if(!load_glyph_outline_by_index(face, static_cast<FT_UInt>(index), outline)) {
+            return false;
+        }
+
+        for(auto& c : outline.curves) {
+            for(auto* p : { &c.p1, &c.p2, &c.p3 }) {
+                p->x *= em;
+                p->y *= em;
+            }
+        }
+
+        // FT_LOAD_NO_SCALE leaves the advance in font units as well.
+        add(outline.curves, static_cast<float>(face->glyph->advance.x) * em);
+    }
+
+    spdlog::info("Packed {} glyphs, {} curves, {} KiB of curves, {} KiB of bands",
+                 face->num_glyphs,
+                 curve_count(),
+                 m_texels.size() * sizeof(float) / 1024,
+                 m_bands.size() * sizeof(std::uint32_t) / 1024);
+    return true;
+}
+
+auto glyph_buffer::upload() -> bool
+{
+    release();
+
+    int max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+
+    auto const curve_texels = m_texels.size() / 4;
+
+    if(std::max(curve_texels, band_texel_count()) > static_cast<std::size_t>(max_texels)) {
+        spdlog::error("{} curves need {} curve and {} band texels, the driver's buffer textures hold {}",
+                      curve_count(),
+                      curve_texels,
+                      band_texel_count(),
+                      max_texels);
+        return false;
+    }
+
+    // An empty buffer is not a valid texture store; keep one blank texel instead.
+    std::array<std::uint32_t, 8> const blank{};
+
+    return create_buffer_texture(m_texels.empty() ? static_cast<void const*>(blank.data()) : m_texels.data(),
+                                 m_texels.empty() ? sizeof(blank) : m_texels.size() * sizeof(float),
+                                 GL_RGBA32F,
+                                 m_buffer,
+                                 m_texture) &&
+           create_buffer_texture(m_bands.empty() ? blank.data() : m_bands.data(),
+                                 m_bands.empty() ? sizeof(blank) : m_bands.size() * sizeof(std::uint32_t),
+                                 GL_RGBA32UI,
+                                 m_band_buffer,
+                                 m_band_texture);
+}
+
+auto glyph_buffer::bind(unsigned int const curve_unit, unsigned int const band_unit) const -> void
+{
+    glActiveTexture(GL_TEXTURE0 + curve_unit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_texture.get());
+    glActiveTexture(GL_TEXTURE0 + band_unit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_band_texture.get());
+}
+
+auto glyph_buffer::release() noexcept -> void
+{
+    m_texture.reset();
+    m_band_texture.reset();
+    m_buffer.reset();
+    m_band_buffer.reset();
+}
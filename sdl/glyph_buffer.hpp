@@ -0,0 +1,102 @@
+#ifndef BEZIER_SDL_GLYPH_BUFFER_HPP
+#define BEZIER_SDL_GLYPH_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "gl_handle.hpp"
+#include "raster.hpp"
+
+// Where a glyph's curves sit in the shared curve texture, the box their control points fit in,
+// where its band block starts in the band texture, and how far the pen moves past it.
+struct glyph_entry
+{
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;
+    point min{ 0.0F, 0.0F };
+    point max{ 0.0F, 0.0F };
+    std::uint32_t bands = 0;
+    std::uint32_t band_base = 0;
+    float advance = 0.0F;
+};
+
+// Most bands per axis. Glyphs get about one band per sqrt(curve count).
+constexpr std::uint32_t max_glyph_bands = 16;
+
+// The outlines of any number of glyphs packed into two buffer textures, uploaded once and shared
+// by every draw.
+//
+// Curves (RGBA32F): curve i takes texels 2i = (p1, p2) and 2i + 1 = (p3, 0, 0).
+//
+// Bands (RGBA32UI): the glyph's box is cut into `bands` equal horizontal and vertical strips,
+// and each strip lists the curves whose control points reach into it, so a fragment only tests
+// the curves near its own row and column. A glyph's block at `band_base` holds
+//   base + 0               the box as float bits (min.x, min.y, max.x, max.y)
+//   base + 1               (bands, first curve, curve count, 0)
+//   base + 2 + b           horizontal strip b from the bottom: (first texel, curve count, 0, 0)
+//   base + 2 + bands + b   vertical strip b from the left: likewise
+// followed by the curve index lists, four per texel. Horizontal lists are sorted by descending
+// maximum x, vertical ones by descending maximum y: a ray towards +x (+y) can stop at the first
+// curve that lies wholly more than half a pixel behind the sample.
+class glyph_buffer
+{
+public:
+    // Appends one glyph and returns its id. Curves whose points all coincide are dropped.
+    auto add(std::vector<curve> const& curves, float advance = 0.0F) -> std::uint32_t;
+
+    // Appends every glyph of `face`, scaled to em units (1.0 = units_per_EM). Glyph index i gets
+    // id `first_id + i`.
+    [[nodiscard]] auto add_font(FT_Face face, std::uint32_t& first_id) -> bool;
+
+    // Creates (or replaces) the GL buffers and textures.
+    [[nodiscard]] auto upload() -> bool;
+
+    auto bind(unsigned int curve_unit, unsigned int band_unit) const -> void;
+
+    [[nodiscard]] auto entry(std::uint32_t const id) const -> glyph_entry const&
+    {
+        return m_entries[id];
+    }
+
+    [[nodiscard]] auto glyph_count() const noexcept -> std::size_t
+    {
+        return m_entries.size();
+    }
+
+    [[nodiscard]] auto curve_count() const noexcept -> std::size_t
+    {
+        return m_texels.size() / 8;
+    }
+
+    [[nodiscard]] auto band_texel_count() const noexcept -> std::size_t
+    {
+        return m_bands.size() / 4;
+    }
+
+    // The band texture's contents, four values per texel, as uploaded.
+    [[nodiscard]] auto band_data() const noexcept -> std::vector<std::uint32_t> const&
+    {
+        return m_bands;
+    }
+
+    auto release() noexcept -> void;
+
+private:
+    auto add_bands(glyph_entry& e) -> void;
+
+    std::vector<float> m_texels;
+    std::vector<std::uint32_t> m_bands;
+    std::vector<glyph_entry> m_entries;
+    gl_buffer m_buffer;
+    gl_texture m_texture;
+    gl_buffer m_band_buffer;
+    gl_texture m_band_texture;
+};
+
+#endif // BEZIER_SDL_GLYPH_BUFFER_HPP
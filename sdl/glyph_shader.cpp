@@ -0,0 +1,217 @@
+#include "glyph_shader.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+// Sources without a #version line; glyph_program_description puts it and the variant's
+// #defines in front.
+constexpr char const* vertex_source = R"(
+    layout(location = 0) in vec2 corner;
+    layout(location = 1) in vec2 origin;
+    layout(location = 2) in float scale;
+    layout(location = 3) in vec4 frame;
+    layout(location = 4) in vec4 color;
+    layout(location = 5) in int glyph;
+
+    layout(std140) uniform frame_state {
+        mat4 u_projection;
+        mat4 u_model;
+        vec2 u_viewport;
+    };
+
+    out vec2 o_coord;
+    out vec4 o_color;
+    flat out int o_glyph;
+
+    // Where glyph-space point `p` of this instance lands on screen, in pixels.
+    vec2 to_pixels(vec2 p) {
+        vec4 clip = u_projection * u_model * vec4(origin + p * scale, 0.0, 1.0);
+        return clip.xy / max(clip.w, 1e-6) * 0.5 * u_viewport;
+    }
+
+    void main() {
+        // The frame hugs the control points; push each corner one pixel further out, measured at
+        // the corner itself, so antialiased edges survive any zoom, rotation or perspective.
+        vec2 coord = mix(frame.xy, frame.zw, corner);
+        float h = max(frame.z - frame.x, frame.w - frame.y) * 0.01 + 1e-6;
+        vec2 base = to_pixels(coord);
+        vec2 pixels_per_unit = vec2(length(to_pixels(coord + vec2(h, 0.0)) - base),
+                                    length(to_pixels(coord + vec2(0.0, h)) - base)) / h;
+        coord += (corner * 2.0 - 1.0) / max(pixels_per_unit, vec2(1e-6));
+
+        gl_Position = u_projection * u_model * vec4(origin + coord * scale, 0.0, 1.0);
+        o_coord = coord;
+        o_color = color;
+        o_glyph = glyph;
+    }
+    )";
+
+// Curves come from the shared glyph buffer. o_glyph is the glyph's band block: each fragment
+// only tests the curves listed for its own horizontal and vertical strip.
+constexpr char const* fragment_source = R"(
+    in vec2 o_coord;
+    in vec4 o_color;
+    flat in int o_glyph;
+    out vec4 frag_color;
+
+    uniform samplerBuffer u_curves;
+    uniform usamplerBuffer u_bands;
+
+    float eval_curve(float y1, float y2, float y3, float t) {
+        float mt = 1.0 - t;
+        return mt * mt * y1 + 2.0 * t * mt * y2 + t * t * y3;
+    }
+
+    // Signed coverage along one axis over the curves of `strip`: (first list texel, count) with
+    // bands, (first curve, count) without. `swap` casts the ray vertically instead of horizontally.
+    float ray_coverage(vec2 coord, float ppem, bool swap, uvec4 strip) {
+        float coverage = 0.0;
+
+        for(uint j = 0u; j < strip.y; ++j) {
+            #if BANDS
+            int i = int(texelFetch(u_bands, int(strip.x + (j >> 2u)))[j & 3u]);
+            #else
+            int i = int(strip.x + j);
+            #endif
+            vec4 head = texelFetch(u_curves, 2 * i);
+            vec4 tail = texelFetch(u_curves, 2 * i + 1);
+
+            vec2 p1 = (swap ? head.yx : head.xy) - coord;
+            vec2 p2 = (swap ? head.wz : head.zw) - coord;
+            vec2 p3 = (swap ? tail.yx : tail.xy) - coord;
+
+            #if BANDS
+            // The strip is sorted by how far its curves reach along the ray; from here on they all
+            // lie more than half a pixel behind the sample and add nothing.
+            if(max(max(p1.x, p2.x), p3.x) * ppem < -0.5) {
+                break;
+            }
+            #endif
+
+            int num = ((p1.y > 0.0) ? 2 : 0) + ((p2.y > 0.0) ? 4 : 0) + ((p3.y > 0.0) ? 8 : 0);
+            int sh = 0x2E74 >> num;
+
+            if((sh & 3) == 0) {
+                continue;
+            }
+
+            float a = p1.y - 2 * p2.y + p3.y;
+            float b = p1.y - p2.y;
+            float c = p1.y;
+
+            float t1 = 0.0;
+            float t2 = 0.0;
+
+            if(abs(a) < 0.0001) {
+                t1 = c / (2.0 * b);
+                t2 = c / (2.0 * b);
+            }
+            else {
+                float root = sqrt(max(b * b - a * c, 0.0));
+                t1 = (b - root) / a;
+                t2 = (b + root) / a;
+            }
+
+            if((sh & 1) != 0) {
+                float r1 = eval_curve(p1.x, p2.x, p3.x, t1);
+                coverage += clamp(r1 * ppem + 0.5, 0.0, 1.0);
+            }
+            if((sh & 2) != 0) {
+                float r2 = eval_curve(p1.x, p2.x, p3.x, t2);
+                coverage -= clamp(r2 * ppem + 0.5, 0.0, 1.0);
+            }
+        }
+
+        return coverage;
+    }
+
+    // Folds a winding sum into coverage.
+    float fill(float winding) {
+        #if EVEN_ODD
+        return 1.0 - abs(1.0 - mod(abs(winding), 2.0));
+        #else
+        return min(abs(winding), 1.0);
+        #endif
+    }
+
+    void main() {
+        vec2 ppem = vec2(1.0 / fwidth(o_coord.x), 1.0 / fwidth(o_coord.y));
+
+        vec4 box = uintBitsToFloat(texelFetch(u_bands, o_glyph));
+        uvec4 header = texelFetch(u_bands, o_glyph + 1);
+        int bands = int(header.x);
+
+        if(bands == 0) {
+            frag_color = vec4(0.0);
+            return;
+        }
+
+        #if BANDS
+        vec2 cell = (o_coord - box.xy) / max(box.zw - box.xy, vec2(1e-6)) * float(bands);
+        ivec2 band = clamp(ivec2(floor(cell)), ivec2(0), ivec2(bands - 1));
+        uvec4 row = texelFetch(u_bands, o_glyph + 2 + band.y);
+        uvec4 column = texelFetch(u_bands, o_glyph + 2 + bands + band.x);
+        #else
+        uvec4 row = uvec4(header.yz, 0u, 0u);
+        uvec4 column = row;
+        #endif
+
+        float coverage = fill(ray_coverage(o_coord, ppem.x, false, row));
+        #if BOTH_AXES
+        coverage = (coverage + fill(ray_coverage(o_coord.yx, ppem.y, true, column))) / 2.0;
+        #endif
+        frag_color = vec4(o_color * coverage);
+    }
+    )";
+
+} // namespace
+
+auto variant_key(shader_options const& options) -> std::uint32_t
+{
+    return (options.bands ? 1U : 0U) | (options.both_axes ? 2U : 0U) |
+           (options.fill == fill_rule::even_odd ? 4U : 0U);
+}
+
+auto variant_name(shader_options const& options) -> std::string
+{
+    return fmt::format("{}+{}+{}",
+                       options.bands ? "bands" : "all_curves",
+                       options.both_axes ? "both_axes" : "horizontal",
+                       options.fill == fill_rule::even_odd ? "even_odd" : "nonzero");
+}
+
+auto glyph_program_description(shader_options const& options) -> program_description
+{
+    auto const preamble = fmt::format("#version 330 core\n"
+                                      "#define BANDS {}\n"
+                                      "#define BOTH_AXES {}\n"
+                                      "#define EVEN_ODD {}\n",
+                                      options.bands ? 1 : 0,
+                                      options.both_axes ? 1 : 0,
+                                      options.fill == fill_rule::even_odd ? 1 : 0);
+
+    program_description desc;
+    desc.vertex_shader_source = preamble + vertex_source;
+    desc.fragment_shader_source = preamble + fragment_source;
+    return desc;
+}
+
+auto bind_glyph_program_interface(unsigned int const program) -> bool
+{
+    auto const block = glGetUniformBlockIndex(program, "frame_state");
+    int const curves = glGetUniformLocation(program, "u_curves");
+    int const bands = glGetUniformLocation(program, "u_bands");
+
+    if(block == GL_INVALID_INDEX || curves < 0 || bands < 0) {
+        spdlog::error("Glyph program lacks frame_state, u_curves or u_bands");
+        return false;
+    }
+
+    glUniformBlockBinding(program, block, frame_state_binding);
+    glUseProgram(program);
+    glUniform1i(curves, static_cast<int>(curve_texture_unit));
+    glUniform1i(bands, static_cast<int>(band_texture_unit));
+    return true;
+}
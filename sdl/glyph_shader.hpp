@@ -0,0 +1,43 @@
+#ifndef BEZIER_SDL_GLYPH_SHADER_HPP
+#define BEZIER_SDL_GLYPH_SHADER_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "gl_program.hpp"
+
+enum class fill_rule
+{
+    nonzero,
+    even_odd
+};
+
+// What a glyph program is compiled for. Each combination is its own variant, selected with
+// #defines in front of one shared source.
+struct shader_options
+{
+    // Test only the curves of the fragment's band strips instead of all of the glyph's curves.
+    bool bands = true;
+    // Average a vertical ray with the horizontal one; off halves the work at some edge quality.
+    bool both_axes = true;
+    fill_rule fill = fill_rule::nonzero;
+};
+
+// Small integer that tells variants apart, e.g. as a map key.
+[[nodiscard]] auto variant_key(shader_options const& options) -> std::uint32_t;
+
+// Readable variant name for logs, e.g. "bands+both_axes+nonzero".
+[[nodiscard]] auto variant_name(shader_options const& options) -> std::string;
+
+[[nodiscard]] auto glyph_program_description(shader_options const& options) -> program_description;
+
+// Fixed slots every glyph variant reads from, so switching programs needs no rebinding.
+constexpr unsigned int curve_texture_unit = 0;
+constexpr unsigned int band_texture_unit = 1;
+constexpr unsigned int frame_state_binding = 0;
+
+// Points a freshly linked (or loaded) program's samplers and frame_state block at the slots
+// above. Its uniforms are looked up here once and never by name again. Leaves it in use.
+[[nodiscard]] auto bind_glyph_program_interface(unsigned int program) -> bool;
+
+#endif // BEZIER_SDL_GLYPH_SHADER_HPP
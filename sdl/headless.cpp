@@ -0,0 +1,211 @@
+#include "headless.hpp"
+
+#include <cstring>
+
+#include <glad/glad.h>
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+auto load_proc(char const* name) -> void*
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+auto surfaceless_display() -> EGLDisplay
+{
+    auto const get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if(get_platform_display == nullptr) {
+        return EGL_NO_DISPLAY;
+    }
+    return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+}
+
+} // namespace
+
+headless_context::~headless_context()
+{
+    release();
+}
+
+auto headless_context::create() -> bool
+{
+    EGLDisplay display = surfaceless_display();
+    EGLint major = 0;
+    EGLint minor = 0;
+
+    if(display == EGL_NO_DISPLAY || eglInitialize(display, &major, &minor) != EGL_TRUE) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        if(display == EGL_NO_DISPLAY || eglInitialize(display, &major, &minor) != EGL_TRUE) {
+            spdlog::error("No EGL display available");
+            return false;
+        }
+    }
+    m_display = display;
+
+    if(eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+        spdlog::error("EGL {}.{} cannot create desktop OpenGL contexts", major, minor);
+        return false;
+    }
+
+    EGLint const config_attributes[] = { EGL_SURFACE_TYPE,
+                                         EGL_PBUFFER_BIT,
+                                         EGL_RENDERABLE_TYPE,
+                                         EGL_OPENGL_BIT,
+                                         EGL_RED_SIZE,
+                                         8,
+                                         EGL_GREEN_SIZE,
+                                         8,
+                                         EGL_BLUE_SIZE,
+                                         8,
+                                         EGL_ALPHA_SIZE,
+                                         8,
+                                         EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+
+    if(eglChooseConfig(display, config_attributes, &config, 1, &configs) != EGL_TRUE || configs == 0) {
+        spdlog::error("No EGL config for an RGBA8 OpenGL pbuffer");
+        return false;
+    }
+
+    EGLint const context_attributes[] = { EGL_CONTEXT_MAJOR_VERSION,
+                                          3,
+                                          EGL_CONTEXT_MINOR_VERSION,
+                                          3,
+                                          EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                          EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                          EGL_NONE };
+
+    m_context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+
+    if(m_context == EGL_NO_CONTEXT) {
+        spdlog::error("Could not create an OpenGL 3.3 core context through EGL");
+        return false;
+    }
+
+    // Rendering goes to a framebuffer object either way; the pbuffer only exists for drivers
+    // that cannot make a context current without a surface.
+    char const* extensions = eglQueryString(display, EGL_EXTENSIONS);
+
+    if(extensions == nullptr || std::strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr) {
+        EGLint const pbuffer_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        m_surface = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+    }
+
+    if(eglMakeCurrent(display, m_surface, m_surface, m_context) != EGL_TRUE) {
+        spdlog::error("Could not make the headless context current");
+        return false;
+    }
+
+    if(gladLoadGLLoader(load_proc) == 0) {
+        spdlog::error("Could not load OpenGL functions through EGL");
+        return false;
+    }
+
+    spdlog::info(
+        "Headless EGL {}.{} context: {}", major, minor, reinterpret_cast<char const*>(glGetString(GL_RENDERER)));
+    return true;
+}
+
+auto headless_context::release() noexcept -> void
+{
+    if(m_display == nullptr) {
+        return;
+    }
+
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if(m_surface != nullptr) {
+        eglDestroySurface(m_display, m_surface);
+        m_surface = nullptr;
+    }
+    if(m_context != nullptr) {
+        eglDestroyContext(m_display, m_context);
+        m_context = nullptr;
+    }
+
+    eglTerminate(m_display);
+    m_display = nullptr;
+}
+
+auto offscreen_target::create(int const width, int const height) -> bool
+{
+    release();
+
+    m_width = width;
+    m_height = height;
+
+    m_color.create();
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color.get());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    m_framebuffer.create();
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer.get());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color.get());
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        spdlog::error("The {}x{} offscreen framebuffer is incomplete", width, height);
+        return false;
+    }
+
+    m_pixels.create();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixels.get());
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 3, nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glViewport(0, 0, width, height);
+    return glGetError() == GL_NO_ERROR;
+}
+
+auto offscreen_target::start_readback() const -> void
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer.get());
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixels.get());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+auto offscreen_target::finish_readback(std::vector<std::uint8_t>& rgb) const -> bool
+{
+    auto const row = static_cast<std::size_t>(m_width) * 3;
+    rgb.resize(row * static_cast<std::size_t>(m_height));
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixels.get());
+    auto const* pixels = static_cast<std::uint8_t const*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(rgb.size()), GL_MAP_READ_BIT));
+
+    if(pixels == nullptr) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        spdlog::error("Could not map the readback buffer");
+        return false;
+    }
+
+    // GL rows run bottom-up. Alpha is left behind: the shader writes premultiplied coverage
+    // there, which a window never shows either.
+    for(int y = 0; y < m_height; ++y) {
+        std::memcpy(rgb.data() + static_cast<std::size_t>(y) * row,
+                    pixels + static_cast<std::size_t>(m_height - 1 - y) * row,
+                    row);
+    }
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+auto offscreen_target::release() noexcept -> void
+{
+    m_pixels.reset();
+    m_framebuffer.reset();
+    m_color.reset();
+}
@@ -0,0 +1,59 @@
+#ifndef BEZIER_SDL_HEADLESS_HPP
+#define BEZIER_SDL_HEADLESS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "gl_handle.hpp"
+
+// An OpenGL 3.3 core context with no window and no display server, for CI and batch jobs.
+// It comes from EGL on Mesa's surfaceless platform (which includes llvmpipe on machines
+// without a GPU), or from the default EGL display with a 1x1 pbuffer where that is missing.
+class headless_context
+{
+public:
+    headless_context() = default;
+    headless_context(headless_context const&) = delete;
+    headless_context(headless_context&&) = delete;
+    ~headless_context();
+
+    auto operator=(headless_context const&) -> headless_context& = delete;
+    auto operator=(headless_context&&) -> headless_context& = delete;
+
+    // Creates the context, makes it current and loads the GL functions.
+    [[nodiscard]] auto create() -> bool;
+
+    auto release() noexcept -> void;
+
+private:
+    // EGLDisplay, EGLContext and EGLSurface, kept opaque so users need no EGL headers.
+    void* m_display = nullptr;
+    void* m_context = nullptr;
+    void* m_surface = nullptr;
+};
+
+// An RGBA8 framebuffer to draw into instead of a window. `start_readback` queues a copy into a
+// pixel buffer object and returns at once, so the copy overlaps whatever is issued next; the
+// CPU only waits in `finish_readback`, when it maps the result.
+class offscreen_target
+{
+public:
+    // Creates the framebuffer and binds it for drawing.
+    [[nodiscard]] auto create(int width, int height) -> bool;
+
+    auto start_readback() const -> void;
+
+    // The pixels of the last `start_readback` as top-down RGB rows.
+    [[nodiscard]] auto finish_readback(std::vector<std::uint8_t>& rgb) const -> bool;
+
+    auto release() noexcept -> void;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    gl_framebuffer m_framebuffer;
+    gl_renderbuffer m_color;
+    gl_buffer m_pixels;
+};
+
+#endif // BEZIER_SDL_HEADLESS_HPP
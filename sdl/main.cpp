@@ -6,80 +6,31 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "encode.hpp"
+#include "frame_state.hpp"
+#include "frame_stats.hpp"
+#include "gl_program.hpp"
+#include "glyph_buffer.hpp"
+#include "headless.hpp"
+#include "program_cache.hpp"
+#include "stream_buffer.hpp"
+#include "text_run.hpp"
+#include "trace.hpp"
 
 #define INFO(...) spdlog::info(__VA_ARGS__)
 #define FATAL(...) spdlog::error(__VA_ARGS__)
 
-struct program_description
-{
-    std::string vertex_shader_source;
-    std::string fragment_shader_source;
-};
-
-[[nodiscard]] auto create_shader(std::string const& source, unsigned int const type) -> unsigned int
-{
-    unsigned int shader = glCreateShader(type);
-
-    char const* src = source.c_str();
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-
-    int succeded = 0;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &succeded);
-
-    if(succeded != GL_TRUE) {
-        int len = 0;
-        std::string msg;
-
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
-        msg.resize(static_cast<std::size_t>(len));
-        glGetShaderInfoLog(shader, static_cast<int>(msg.size()), nullptr, msg.data());
-
-        std::string const shader_type = (type == GL_VERTEX_SHADER ? "vertex" : "fragment");
-        FATAL("Compilation of {} shader failed: {}", shader_type, msg);
-    }
-
-    return shader;
-}
-
-[[nodiscard]] auto create_program(program_description const& desc) -> unsigned int
-{
-    unsigned int program = glCreateProgram();
-
-    auto const vs = create_shader(desc.vertex_shader_source, GL_VERTEX_SHADER);
-    auto const fs = create_shader(desc.fragment_shader_source, GL_FRAGMENT_SHADER);
-
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-
-    int succeded = 0;
-    glGetProgramiv(program, GL_LINK_STATUS, &succeded);
-
-    if(succeded != GL_TRUE) {
-        int len = 0;
-        std::string msg;
-
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
-        msg.resize(static_cast<std::size_t>(len));
-        glGetProgramInfoLog(program, static_cast<int>(msg.size()), nullptr, msg.data());
-
-        FATAL("Program could not be linked: {}", msg);
-    }
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-
-    return program;
-}
-
-auto set_mat4(unsigned int program, std::string const& var, glm::mat4 const& mat) noexcept -> void
-{
-    glUniformMatrix4fv(glGetUniformLocation(program, var.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
-}
-
 int width = 800;
 int height = 800;
 
@@ -94,14 +45,19 @@ auto rotate(float const angle, glm::vec3 const& axis) noexcept -> void
     rotation *= glm::toMat4(glm::angleAxis(angle, axis));
 }
 
-auto handle_events(SDL_Window* window, bool& running, unsigned int const program, float const duration) -> void
+// Sets `dirty` when an event changes what the window should show. With `wait_ms`, sleeps until
+// the first event arrives or the time is up instead of returning at once.
+auto handle_events(SDL_Window* window, bool& running, bool& dirty, float const duration, int const wait_ms = 0)
+    -> void
 {
     static float translate_offset = 1.5F;
     constexpr float scale_offset = 2.0F;
     constexpr float rotate_offset = 2.0F;
 
     SDL_Event ev;
-    while(SDL_PollEvent(&ev)) {
+    bool pending = wait_ms > 0 ? SDL_WaitEventTimeout(&ev, wait_ms) != 0 : SDL_PollEvent(&ev) != 0;
+
+    for(; pending; pending = SDL_PollEvent(&ev) != 0) {
         if(ev.type == SDL_QUIT) {
             running = false;
             break;
@@ -117,12 +73,17 @@ auto handle_events(SDL_Window* window, bool& running, unsigned int const program
                 height = ev.window.data2;
                 glViewport(0, 0, width, height);
                 projection = glm::perspective(fov, (width * 1.0F) / (height * 1.0F), 0.1F, 100.0F);
-                set_mat4(program, "u_projection", projection);
+                dirty = true;
                 INFO("Window resize: w={}, h={}", width, height);
             }
+            else if(ev.window.event == SDL_WINDOWEVENT_EXPOSED) {
+                dirty = true;
+            }
             break;
         }
         case SDL_KEYDOWN: {
+            bool moved = true;
+
             switch(ev.key.keysym.sym) {
             case SDLK_ESCAPE: {
                 running = false;
@@ -179,9 +140,11 @@ auto handle_events(SDL_Window* window, bool& running, unsigned int const program
                 break;
             }
             default: {
+                moved = false;
                 break;
             }
             }
+            dirty = dirty || moved;
             break;
         }
         case SDL_MOUSEWHEEL: {
@@ -189,7 +152,7 @@ auto handle_events(SDL_Window* window, bool& running, unsigned int const program
             translate_offset -= ev.wheel.y * duration * 1.5F;
             fov = std::clamp(fov, 44.0F, 46.7F);
             projection = glm::perspective(fov, (width * 1.0F) / (height * 1.0F), 0.1F, 100.0F);
-            set_mat4(program, "u_projection", projection);
+            dirty = true;
             break;
         }
         default: {
@@ -199,241 +162,514 @@ auto handle_events(SDL_Window* window, bool& running, unsigned int const program
     }
 }
 
-auto main() noexcept -> int
+auto main(int argc, char** argv) noexcept -> int
 {
-    if(SDL_Init(SDL_INIT_VIDEO) != 0) {
-        FATAL("Couldn't initialize SDL!");
-    }
-
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-
-    SDL_Window* window = SDL_CreateWindow("Bezier",
-                                          SDL_WINDOWPOS_CENTERED,
-                                          SDL_WINDOWPOS_CENTERED,
-                                          width,
-                                          height,
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
-
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-
-    SDL_GLContext ctx = SDL_GL_CreateContext(window);
+    std::string trace_path;
+    std::string font_path;
+    std::string text;
+    FT_ULong char_code = 'B';
+    shader_options shader;
+    std::string shader_cache_path;
+    bool shader_cache_given = false;
+    bool hud = false;
+    std::string headless_path;
+    int benchmark_frames = 0;
+    bool stats = false;
+    bool on_demand = false;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string const arg = argv[i];
+
+        if(arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        }
+        else if(arg == "--font" && i + 1 < argc) {
+            font_path = argv[++i];
+        }
+        else if(arg == "--char" && i + 1 < argc) {
+            char_code = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if(arg == "--text" && i + 1 < argc) {
+            text = argv[++i];
+        }
+        else if(arg == "--fill" && i + 1 < argc) {
+            std::string const rule = argv[++i];
 
-    SDL_GL_SetSwapInterval(1);
+            if(rule != "nonzero" && rule != "even-odd") {
+                FATAL("Unknown fill rule {}; use nonzero or even-odd", rule);
+                return 1;
+            }
+            shader.fill = rule == "even-odd" ? fill_rule::even_odd : fill_rule::nonzero;
+        }
+        else if(arg == "--hud") {
+            hud = true;
+        }
+        else if(arg == "--no-bands") {
+            shader.bands = false;
+        }
+        else if(arg == "--horizontal-only") {
+            shader.both_axes = false;
+        }
+        else if(arg == "--shader-cache" && i + 1 < argc) {
+            shader_cache_path = argv[++i];
+            shader_cache_given = true;
+        }
+        else if(arg == "--headless" && i + 1 < argc) {
+            headless_path = argv[++i];
+        }
+        else if(arg == "--benchmark" && i + 1 < argc) {
+            benchmark_frames = std::atoi(argv[++i]);
 
-    if(!gladLoadGLLoader(SDL_GL_GetProcAddress)) {
-        FATAL("Couldn't create OpenGL context!");
+            if(benchmark_frames <= 0) {
+                FATAL("--benchmark takes a frame count");
+                return 1;
+            }
+        }
+        else if(arg == "--stats") {
+            stats = true;
+        }
+        else if(arg == "--on-demand") {
+            on_demand = true;
+        }
+        else if(arg == "--size" && i + 1 < argc) {
+            if(std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                FATAL("--size takes WIDTHxHEIGHT, e.g. 1920x1080");
+                return 1;
+            }
+        }
+        else {
+            FATAL("Usage: {} [--trace path.json] [--font path] [--char code] [--text string] [--fill nonzero|even-odd] "
+                  "[--no-bands] [--horizontal-only] [--shader-cache dir] [--hud] [--stats] [--benchmark frames] "
+                  "[--on-demand] [--headless out.png] [--size WxH]",
+                  argv[0]);
+            return 1;
+        }
     }
 
-    INFO("OpenGL context created! Version {}.{}!", GLVersion.major, GLVersion.minor);
-
-    program_description desc;
-
-    desc.vertex_shader_source = R"(
-    #version 330 core
+    if((!text.empty() || hud) && font_path.empty()) {
+        FATAL("--text and --hud need --font");
+        return 1;
+    }
 
-    layout(location = 0) in vec2 pos;
-    layout(location = 1) in vec2 coord;
-    layout(location = 2) in vec4 color;
+    enable_tracing(!trace_path.empty());
+    set_trace_thread_name("main");
 
-    uniform mat4 u_model;
-    uniform mat4 u_projection;
+    // --headless draws one frame through EGL into an offscreen framebuffer and writes it out,
+    // without a window or a display server.
+    bool const headless = !headless_path.empty();
+    headless_context offscreen_context;
 
-    out vec2 o_coord;
-    out vec4 o_color;
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    SDL_GLContext ctx = nullptr;
 
-    void main() {
-        gl_Position = u_projection * u_model * vec4(pos.xy, 0.0, 1.0);
-        o_coord = coord;
-        o_color = color;
+    if(headless) {
+        if(!offscreen_context.create()) {
+            FATAL("Couldn't create a headless OpenGL context!");
+            return 1;
+        }
     }
-    )";
-
-    desc.fragment_shader_source = R"(
-    #version 330 core
+    else {
+        if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+            FATAL("Couldn't initialize SDL!");
+        }
 
-    in vec2 o_coord;
-    in vec4 o_color;
-    out vec4 frag_color;
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 
-    #define NUM_BEZIER_CURVES 6
-    #define NUM_CONTROL_POINTS 3
+        window = SDL_CreateWindow("Bezier",
+                                  SDL_WINDOWPOS_CENTERED,
+                                  SDL_WINDOWPOS_CENTERED,
+                                  width,
+                                  height,
+                                  SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
 
-    uniform vec2 u_curves[NUM_BEZIER_CURVES * NUM_CONTROL_POINTS];
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
-    float eval_curve(float y1, float y2, float y3, float t) {
-        float mt = 1.0 - t;
-        return mt * mt * y1 + 2.0 * t * mt * y2 + t * t * y3;
-    }
+        ctx = SDL_GL_CreateContext(window);
 
-    void main() {
-        float coverage = 0.0;
-        vec2 ppem = vec2(1.0 / fwidth(o_coord.x), 1.0 / fwidth(o_coord.y));
+        // A benchmark measures how fast frames can be drawn, not the display's refresh rate.
+        SDL_GL_SetSwapInterval(benchmark_frames > 0 ? 0 : 1);
 
-        for(int i = 0; i < NUM_BEZIER_CURVES * NUM_CONTROL_POINTS; i += NUM_CONTROL_POINTS) {
-            vec2 p1 = u_curves[i] - o_coord;
-            vec2 p2 = u_curves[i + 1] - o_coord;
-            vec2 p3 = u_curves[i + 2] - o_coord;
-
-            float a = p1.y - 2 * p2.y + p3.y;
-            float b = p1.y - p2.y;
-            float c = p1.y;
+        if(!gladLoadGLLoader(SDL_GL_GetProcAddress)) {
+            FATAL("Couldn't create OpenGL context!");
+        }
+    }
 
-            float t1 = 0.0;
-            float t2 = 0.0;
+    INFO("OpenGL context created! Version {}.{}!", GLVersion.major, GLVersion.minor);
 
-            if(abs(a) < 0.0001) {
-                t1 = c / (2.0 * b);
-                t2 = c / (2.0 * b);
-            }
-            else {
-                float root = sqrt(max(b * b - a * c, 0.0));
-                t1 = (b - root) / a;
-                t2 = (b + root) / a;
-            }
+    std::vector<curve> const scene = {
+        { { 0.3F, 0.3F }, { 0.5F, 0.5F }, { 0.3F, 0.7F } },     // first curve
+        { { 0.3F, 0.7F }, { 1.0F, 0.5F }, { 0.3F, 0.3F } },     // second curve
+        { { 0.9F, 0.3F }, { 0.9F, 0.5F }, { 0.9F, 0.7F } },     // third curve
+        { { 0.9F, 0.7F }, { 0.93F, 0.7F }, { 0.95F, 0.7F } },   // fourth curve
+        { { 0.95F, 0.7F }, { 0.95F, 0.5F }, { 0.95F, 0.3F } }, // fifth curve
+        { { 0.95F, 0.3F }, { 0.93F, 0.3F }, { 0.9F, 0.3F } }    // sixth curve
+    };
 
-            int num = ((p1.y > 0.0) ? 2 : 0) + ((p2.y > 0.0) ? 4 : 0) + ((p3.y > 0.0) ? 8 : 0);
-            int sh = 0x2E74 >> num;
+    // The scene is glyph 0; with --font, every glyph of the font follows it in the same buffer.
+    glyph_buffer glyphs;
+    std::uint32_t const scene_id = glyphs.add(scene);
 
-            if((sh & 1) != 0) {
-                float r1 = eval_curve(p1.x, p2.x, p3.x, t1);
-                coverage += clamp(r1 * ppem.x + 0.5, 0.0, 1.0);
-            }
-            if((sh & 2) != 0) {
-                float r2 = eval_curve(p1.x, p2.x, p3.x, t2);
-                coverage -= clamp(r2 * ppem.x + 0.5, 0.0, 1.0);
-            }
+    glm::vec4 const color{ 1.0F, 128.0F / 255.0F, 64.0F / 255.0F, 1.0F };
+    std::vector<glyph_instance> instances;
+
+    // The face stays open for laying out the HUD every frame.
+    FT_Library library = nullptr;
+    FT_Face face = nullptr;
+    std::uint32_t first_id = 0;
+
+    if(font_path.empty()) {
+        // The scene keeps its place: its unit square spans the whole view.
+        auto const& e = glyphs.entry(scene_id);
+        instances.push_back(glyph_instance{
+            { -1.0F, -1.0F }, 2.0F, glyph_frame(e), color, static_cast<std::int32_t>(e.band_base) });
+    }
+    else {
+        if(FT_Init_FreeType(&library) != 0 || FT_New_Face(library, font_path.c_str(), 0, &face) != 0) {
+            FATAL("Could not open font {}", font_path);
+            return 1;
+        }
+        if(!glyphs.add_font(face, first_id)) {
+            return 1;
         }
 
-        float coverage2 = 0.0;
-
-        for(int i = 0; i < NUM_BEZIER_CURVES * NUM_CONTROL_POINTS; i += NUM_CONTROL_POINTS) {
-            vec2 p1 = u_curves[i].yx - o_coord.yx;
-            vec2 p2 = u_curves[i + 1].yx - o_coord.yx;
-            vec2 p3 = u_curves[i + 2].yx - o_coord.yx;
-
-            float a = p1.y - 2 * p2.y + p3.y;
-            float b = p1.y - p2.y;
-            float c = p1.y;
+        if(!text.empty()) {
+            layout_text(glyphs, face, first_id, text, color, instances);
+        }
+        else {
+            auto const& e = glyphs.entry(first_id + FT_Get_Char_Index(face, char_code));
+            instances.push_back(
+                glyph_instance{ { 0.0F, 0.0F }, 1.0F, glyph_frame(e), color, static_cast<std::int32_t>(e.band_base) });
+        }
 
-            float t1 = 0.0;
-            float t2 = 0.0;
+        fit_instances(instances, 0.9F);
+    }
 
-            if(abs(a) < 0.0001) {
-                t1 = c / (2.0 * b);
-                t2 = c / (2.0 * b);
-            }
-            else {
-                float root = sqrt(max(b * b - a * c, 0.0));
-                t1 = (b - root) / a;
-                t2 = (b + root) / a;
-            }
+    INFO("Drawing {} glyph instances in one call", instances.size());
 
-            int num = ((p1.y > 0.0) ? 2 : 0) + ((p2.y > 0.0) ? 4 : 0) + ((p3.y > 0.0) ? 8 : 0);
-            int sh = 0x2E74 >> num;
+    if(!glyphs.upload()) {
+        FATAL("Could not upload {} curves", glyphs.curve_count());
+        return 1;
+    }
 
-            if((sh & 1) != 0) {
-                float r1 = eval_curve(p1.x, p2.x, p3.x, t1);
-                coverage2 += clamp(r1 * ppem.y + 0.5, 0.0, 1.0);
-            }
-            if((sh & 2) != 0) {
-                float r2 = eval_curve(p1.x, p2.x, p3.x, t2);
-                coverage2 -= clamp(r2 * ppem.y + 0.5, 0.0, 1.0);
-            }
+    // Program binaries go to the per-user data directory unless --shader-cache names another one
+    // (an empty name turns the disk cache off). Headless runs only use one they are given.
+    if(!shader_cache_given && !headless) {
+        if(char* pref = SDL_GetPrefPath("bezier", "Bezier"); pref != nullptr) {
+            shader_cache_path = pref;
+            SDL_free(pref);
         }
-
-        float coverage_h = min(abs(coverage), 1.0);
-        float coverage_v = min(abs(coverage2), 1.0);
-        float avg_coverage = (coverage_h + coverage_v) / 2.0;
-        frag_color = vec4(o_color * avg_coverage);
     }
-    )";
-
-    std::vector<float> const curves = {
-        0.3F,  0.3F, 0.5F,  0.5F, 0.3F,  0.7F, // first curve
-        0.3F,  0.7F, 1.0F,  0.5F, 0.3F,  0.3F, // second curve
-        0.9F,  0.3F, 0.9F,  0.5F, 0.9F,  0.7F, // third curve
-        0.9F,  0.7F, 0.93F, 0.7F, 0.95F, 0.7F, // fourth curve
-        0.95F, 0.7F, 0.95F, 0.5F, 0.95F, 0.3F, // fifth curve
-        0.95F, 0.3F, 0.93F, 0.3F, 0.9F,  0.3F  // sixth curve
-    };
+    while(!shader_cache_path.empty() && (shader_cache_path.back() == '/' || shader_cache_path.back() == '\\')) {
+        shader_cache_path.pop_back();
+    }
+
+    program_cache programs{ shader_cache_path };
+    auto const program = programs.get(shader);
 
-    auto const program = create_program(desc);
+    if(program == 0) {
+        FATAL("Could not build shader variant {}", variant_name(shader));
+        return 1;
+    }
     glUseProgram(program);
 
     projection = glm::perspective(fov, (width * 1.0F) / (height * 1.0F), 0.1F, 100.0F);
-    set_mat4(program, "u_projection", projection);
 
-    glUniform2fv(glGetUniformLocation(program, "u_curves"), curves.size() / 2, curves.data());
+    frame_state frame;
+
+    if(!frame.create()) {
+        FATAL("Could not create the frame state buffer");
+        return 1;
+    }
+
+    glyphs.bind(curve_texture_unit, band_texture_unit);
 
     unsigned int vao = 0;
     glGenVertexArrays(1, &vao);
     glBindVertexArray(vao);
 
-    glm::vec4 const color{ 1.0F, 128.0F / 255.0F, 64.0F / 255.0F, 1.0F };
-
-    std::array<float, 32> const vertices = {
-        -1.0F, 1.0F,  0.0F, 0.0F, color.r, color.g, color.b, color.a, // TOP LEFT
-        1.0F,  1.0F,  1.0F, 0.0F, color.r, color.g, color.b, color.a, // TOP RIGHT
-        1.0F,  -1.0F, 1.0F, 1.0F, color.r, color.g, color.b, color.a, // BOTTOM RIGHT
-        -1.0F, -1.0F, 0.0F, 1.0F, color.r, color.g, color.b, color.a  // BOTTOM LEFT
-    };
+    // Every instance stretches the same unit quad over its frame, dilated in the vertex shader.
+    std::array<glm::vec2, 4> const corners = { {
+        { 0.0F, 1.0F }, // TOP LEFT
+        { 1.0F, 1.0F }, // TOP RIGHT
+        { 1.0F, 0.0F }, // BOTTOM RIGHT
+        { 0.0F, 0.0F }  // BOTTOM LEFT
+    } };
 
     std::array<unsigned int, 6> const indices = { 0, 1, 2, 2, 3, 0 };
 
     unsigned int vbo = 0;
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(glm::vec2), corners.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), nullptr);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
     glEnableVertexAttribArray(0);
 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Instances are rewritten every frame, straight into mapped memory.
+    stream_buffer instance_stream;
 
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(4 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    if(!instance_stream.create(GL_ARRAY_BUFFER, (instances.size() + 64) * sizeof(glyph_instance))) {
+        FATAL("Could not create the instance stream");
+        return 1;
+    }
+    INFO("Instance stream: {}", instance_stream.persistent() ? "persistent mapping" : "orphaning");
+
+    for(unsigned int location = 1; location <= 5; ++location) {
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+
+    // Re-points the instance attributes at this frame's slice of the stream.
+    auto const point_instances = [&instance_stream](std::size_t const base) {
+        auto const at = [base](std::size_t const offset) { return reinterpret_cast<void*>(base + offset); };
+
+        glBindBuffer(GL_ARRAY_BUFFER, instance_stream.id());
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), at(offsetof(glyph_instance, origin)));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), at(offsetof(glyph_instance, scale)));
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), at(offsetof(glyph_instance, frame)));
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glyph_instance), at(offsetof(glyph_instance, color)));
+        glVertexAttribIPointer(5, 1, GL_INT, sizeof(glyph_instance), at(offsetof(glyph_instance, band_base)));
+    };
+
+    std::vector<glyph_instance> frame_instances;
 
     unsigned int ibo = 0;
     glGenBuffers(1, &ibo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
+    offscreen_target target;
+
+    if(headless && !target.create(width, height)) {
+        FATAL("Could not create a {}x{} offscreen target", width, height);
+        return 1;
+    }
+
+    // GPU time and shaded fragments of the glyph draw, read back a few frames late.
+    gpu_query gpu_time;
+    gpu_query gpu_samples;
+
+    if(!gpu_time.create(GL_TIME_ELAPSED) || !gpu_samples.create(GL_SAMPLES_PASSED)) {
+        FATAL("Could not create the frame timer queries");
+        return 1;
+    }
+
+    GLint samples_per_pixel = 0;
+    glGetIntegerv(GL_SAMPLES, &samples_per_pixel);
+    samples_per_pixel = std::max(samples_per_pixel, 1);
+
+    frame_history cpu_times;
+    frame_history gpu_times;
+    frame_history fragments;
+
+    auto const collect_queries = [&]() {
+        std::uint64_t value = 0;
+
+        while(gpu_time.poll(value)) {
+            gpu_times.add(static_cast<double>(value) / 1e6);
+        }
+        while(gpu_samples.poll(value)) {
+            fragments.add(static_cast<double>(value / static_cast<std::uint64_t>(samples_per_pixel)));
+        }
+    };
+
     glEnable(GL_MULTISAMPLE);
     glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
 
     bool running = true;
+    int status = 0;
+
+    // A headless run draws one frame unless it is a benchmark; a window runs until closed.
+    std::uint64_t const frame_limit = benchmark_frames > 0 ? benchmark_frames : (headless ? 1 : 0);
+    std::uint64_t frames = 0;
+    std::size_t glyphs_drawn = 0;
+
+    // On demand, the loop sleeps in SDL until an event changes the transform or the window and
+    // only then draws and swaps. The only text that changes, the HUD, follows the frames drawn
+    // and never asks for a redraw itself, so an idle view costs one wake-up a second.
+    on_demand = on_demand && !headless && benchmark_frames == 0;
+    constexpr int idle_wait_ms = 1000;
+    bool dirty = true;
 
     using namespace std::chrono;
     auto start = steady_clock::now();
+    auto const first_frame = start;
+    auto last_stats = start;
 
     while(running) {
+        if(on_demand) {
+            trace_span const span{ "wait", "frame" };
+            // Key repeat paces movement here, so every event moves as far as one 60 Hz frame. A
+            // frame that is already due only collects what is queued.
+            handle_events(window, running, dirty, 1.0F / 60.0F, dirty ? 0 : idle_wait_ms);
+        }
+
         auto end = steady_clock::now();
-        auto const duration = duration_cast<milliseconds>(end - start).count() / 1000.0F;
+        auto const duration = std::chrono::duration<float>{ end - start }.count();
         start = end;
-        glm::mat4 model{ 1.0F };
-        model = glm::translate(model, translation);
-        model *= rotation;
-        model = glm::scale(model, scale);
-        set_mat4(program, "u_model", model);
 
-        handle_events(window, running, program, duration);
-        glClear(GL_COLOR_BUFFER_BIT);
+        // On demand, the time between frames is mostly sleep; the frame's own work is added
+        // once it has been swapped.
+        if(frames > 0 && !on_demand) {
+            cpu_times.add(duration * 1000.0);
+        }
+        collect_queries();
+
+        if(stats && end - last_stats >= seconds{ 1 }) {
+            log_frame_times("cpu frame", cpu_times);
+            log_frame_times("gpu draw", gpu_times);
+            INFO("fragments shaded: {:.0f} per frame", fragments.mean());
+            last_stats = end;
+        }
+
+        if(!dirty || !running) {
+            continue;
+        }
+
+        trace_span const frame_span{ "frame", "frame" };
+
+        if(!headless && !on_demand) {
+            trace_span const span{ "events", "frame" };
+            handle_events(window, running, dirty, duration);
+        }
+
+        // Everything the shaders need per frame goes up in one buffer update.
+        frame_uniforms uniforms;
+        uniforms.projection = projection;
+        uniforms.model = glm::scale(glm::translate(glm::mat4{ 1.0F }, translation) * rotation, scale);
+        uniforms.viewport = glm::vec2{ width * 1.0F, height * 1.0F };
+        frame.update(uniforms);
+
+        frame_instances.assign(instances.begin(), instances.end());
+
+        if(hud) {
+            auto const first = frame_instances.size();
+            auto const readout = fmt::format("cpu {:.2f} ms  gpu {:.2f} ms  {:.0f}k fragments",
+                                             cpu_times.mean(),
+                                             gpu_times.mean(),
+                                             fragments.mean() / 1000.0);
+            layout_text(glyphs, face, first_id, readout, color, frame_instances);
+            place_instances(frame_instances, first, glm::vec2{ -0.95F, -0.95F }, 0.08F);
+        }
+
+        // CPU side only: the draw span covers command submission, the GPU work lands in swap.
+        {
+            trace_span const span{ "draw", "frame" };
+
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // An empty text run (and no HUD) leaves nothing to stream or draw.
+            if(!frame_instances.empty()) {
+                auto const bytes = frame_instances.size() * sizeof(glyph_instance);
+                void* const dst = instance_stream.map(bytes);
+
+                if(dst == nullptr) {
+                    FATAL("Could not map {} bytes of instances", bytes);
+                    status = 1;
+                    break;
+                }
+                std::memcpy(dst, frame_instances.data(), bytes);
+                point_instances(instance_stream.unmap());
+
+                gpu_time.begin();
+                gpu_samples.begin();
+                glDrawElementsInstanced(GL_TRIANGLES,
+                                        indices.size(),
+                                        GL_UNSIGNED_INT,
+                                        nullptr,
+                                        static_cast<GLsizei>(frame_instances.size()));
+                gpu_samples.end();
+                gpu_time.end();
+                instance_stream.fence();
+            }
+        }
+
+        glyphs_drawn += frame_instances.size();
+
+        if(++frames == frame_limit) {
+            running = false;
+        }
+
+        if(headless) {
+            if(!running) {
+                trace_span const span{ "readback", "frame" };
+                target.start_readback();
+            }
+        }
+        else {
+            trace_span const span{ "swap", "frame" };
+            SDL_GL_SwapWindow(window);
+        }
 
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, nullptr);
+        if(on_demand) {
+            cpu_times.add(std::chrono::duration<double, std::milli>{ steady_clock::now() - end }.count());
+            dirty = false;
+        }
+    }
 
-        SDL_GL_SwapWindow(window);
+    if(benchmark_frames > 0 && status == 0) {
+        glFinish();
+        collect_queries();
+
+        auto const elapsed = duration<double>(steady_clock::now() - first_frame).count();
+        INFO("Benchmark: {} frames in {:.3f} s, {:.1f} frames/s, {:.0f} glyphs/s",
+             frames,
+             elapsed,
+             frames / elapsed,
+             static_cast<double>(glyphs_drawn) / elapsed);
+        log_frame_times("cpu frame", cpu_times);
+        log_frame_times("gpu draw", gpu_times);
+        INFO("fragments shaded: {:.0f} per frame", fragments.mean());
     }
 
+    if(headless && status == 0) {
+        std::vector<std::uint8_t> rgb;
+        std::vector<std::uint8_t> png;
+
+        if(!target.finish_readback(rgb)
+           || !encode_png(image_view{ rgb.data(), width, height, 3, static_cast<std::size_t>(width) * 3 }, png)
+           || !write_file(headless_path.c_str(), png)) {
+            FATAL("Could not write {}", headless_path);
+            status = 1;
+        }
+        else {
+            INFO("Wrote {}x{} frame to {}", width, height, headless_path);
+        }
+    }
+
+    if(!trace_path.empty() && !write_trace_json(trace_path.c_str())) {
+        FATAL("Could not write trace to {}", trace_path);
+    }
+
+    gpu_samples.release();
+    gpu_time.release();
+    target.release();
+    glyphs.release();
     glDeleteBuffers(1, &ibo);
+    instance_stream.release();
     glDeleteBuffers(1, &vbo);
     glDeleteVertexArrays(1, &vao);
-    glDeleteProgram(program);
+    frame.release();
+    programs.release();
+
+    if(face != nullptr) {
+        FT_Done_Face(face);
+    }
+    if(library != nullptr) {
+        FT_Done_FreeType(library);
+    }
+
+    if(headless) {
+        offscreen_context.release();
+        return status;
+    }
 
     SDL_GL_DeleteContext(ctx);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
+    return status;
 }
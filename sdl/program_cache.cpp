@@ -0,0 +1,221 @@
+#include "program_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+constexpr char cache_magic[4] = { 'B', 'Z', 'P', 'B' };
+
+// FNV-1a; only names the file, the full key inside it is what decides a hit.
+auto hash_key(std::string const& key) -> std::uint64_t
+{
+    std::uint64_t h = 0xCBF29CE484222325ULL;
+    for(char const c : key) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+    }
+    return h;
+}
+
+auto gl_string(GLenum const name) -> std::string
+{
+    auto const* s = reinterpret_cast<char const*>(glGetString(name));
+    return s != nullptr ? s : "";
+}
+
+[[nodiscard]] auto read_file(std::string const& path, std::string& data) -> bool
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+
+    if(file == nullptr) {
+        return false;
+    }
+
+    bool ok = std::fseek(file, 0, SEEK_END) == 0;
+    long const size = ok ? std::ftell(file) : -1;
+    ok = size >= 0 && std::fseek(file, 0, SEEK_SET) == 0;
+
+    if(ok) {
+        data.resize(static_cast<std::size_t>(size));
+        ok = std::fread(data.data(), 1, data.size(), file) == data.size();
+    }
+
+    std::fclose(file);
+    return ok;
+}
+
+auto append_u32(std::string& out, std::uint32_t const v) -> void
+{
+    out.append(reinterpret_cast<char const*>(&v), sizeof(v));
+}
+
+[[nodiscard]] auto take_u32(std::string const& in, std::size_t& at, std::uint32_t& v) -> bool
+{
+    if(in.size() < at + sizeof(v)) {
+        return false;
+    }
+    std::memcpy(&v, in.data() + at, sizeof(v));
+    at += sizeof(v);
+    return true;
+}
+
+[[nodiscard]] auto is_linked(unsigned int const program) -> bool
+{
+    int linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    return linked == GL_TRUE;
+}
+
+} // namespace
+
+program_cache::program_cache(std::string directory)
+    : m_directory{ std::move(directory) }
+{
+}
+
+auto program_cache::get(shader_options const& options) -> unsigned int
+{
+    auto const it = m_programs.find(variant_key(options));
+
+    if(it != m_programs.end()) {
+        return it->second.get();
+    }
+
+    if(m_driver.empty()) {
+        int formats = 0;
+        if(GLAD_GL_ARB_get_program_binary != 0 || GLVersion.major > 4 ||
+           (GLVersion.major == 4 && GLVersion.minor >= 1)) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+
+        m_binaries = formats > 0 && !m_directory.empty();
+        m_driver = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION) + '\n';
+    }
+
+    auto desc = glyph_program_description(options);
+    desc.retrievable = m_binaries;
+
+    auto const key = m_driver + desc.vertex_shader_source + desc.fragment_shader_source;
+    auto const path = fmt::format("{}/glyph-{:016x}.bin", m_directory, hash_key(key));
+
+    unsigned int program = m_binaries ? load(path, key) : 0;
+
+    if(program != 0) {
+        spdlog::info("Loaded shader variant {} from {}", variant_name(options), path);
+    }
+    else {
+        program = create_program(desc);
+
+        if(!is_linked(program)) {
+            glDeleteProgram(program);
+            return 0;
+        }
+        if(m_binaries) {
+            store(path, key, program);
+        }
+        spdlog::info("Compiled shader variant {}", variant_name(options));
+    }
+
+    if(!bind_glyph_program_interface(program)) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    m_programs.emplace(variant_key(options), gl_program{ program });
+    return program;
+}
+
+auto program_cache::load(std::string const& path, std::string const& key) const -> unsigned int
+{
+    std::string data;
+    std::uint32_t format = 0;
+    std::size_t offset = 0;
+
+    if(!read_file(path, data) || !decode_program_cache(data, key, format, offset)) {
+        return 0;
+    }
+
+    // A driver may still refuse a binary it wrote, e.g. after a change the version string hides.
+    unsigned int const program = glCreateProgram();
+    glProgramBinary(program, format, data.data() + offset, static_cast<GLsizei>(data.size() - offset));
+
+    if(!is_linked(program)) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+auto program_cache::store(std::string const& path, std::string const& key, unsigned int const program) const -> void
+{
+    int size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+
+    std::vector<char> binary(static_cast<std::size_t>(size));
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, size, &written, &format, binary.data());
+
+    auto const data = encode_program_cache(key, format, binary.data(), static_cast<std::size_t>(written));
+
+    // Write next to the target and rename, so a concurrent launch never reads half a file.
+    auto const temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    bool ok = file != nullptr && std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = (file == nullptr || std::fclose(file) == 0) && ok;
+
+    if(!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        spdlog::error("Could not write shader cache {}", path);
+    }
+}
+
+auto program_cache::release() noexcept -> void
+{
+    m_programs.clear();
+}
+
+auto encode_program_cache(std::string const& key,
+                          std::uint32_t const format,
+                          char const* binary,
+                          std::size_t const size) -> std::string
+{
+    std::string data{ cache_magic, sizeof(cache_magic) };
+    append_u32(data, static_cast<std::uint32_t>(key.size()));
+    data += key;
+    append_u32(data, format);
+    append_u32(data, static_cast<std::uint32_t>(size));
+    data.append(binary, size);
+    return data;
+}
+
+auto decode_program_cache(std::string const& data,
+                          std::string const& key,
+                          std::uint32_t& format,
+                          std::size_t& offset) -> bool
+{
+    if(data.compare(0, sizeof(cache_magic), cache_magic, sizeof(cache_magic)) != 0) {
+        return false;
+    }
+
+    std::size_t at = sizeof(cache_magic);
+    std::uint32_t key_size = 0;
+    std::uint32_t size = 0;
+
+    if(!take_u32(data, at, key_size) || data.compare(at, key_size, key) != 0) {
+        return false;
+    }
+    at += key_size;
+
+    if(!take_u32(data, at, format) || !take_u32(data, at, size) || data.size() - at != size) {
+        return false;
+    }
+
+    offset = at;
+    return true;
+}
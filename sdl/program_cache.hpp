@@ -0,0 +1,51 @@
+#ifndef BEZIER_SDL_PROGRAM_CACHE_HPP
+#define BEZIER_SDL_PROGRAM_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "gl_handle.hpp"
+#include "glyph_shader.hpp"
+
+// Glyph programs by variant, compiled on first use. With a directory and a driver that offers
+// program binaries, linked programs are written there and later launches load them with
+// glProgramBinary instead of compiling. A cache file is keyed by vendor, renderer, GL version
+// and the exact sources, so a driver update or shader edit simply misses.
+class program_cache
+{
+public:
+    // An empty `directory` keeps programs in memory only.
+    explicit program_cache(std::string directory);
+
+    // The linked program for `options`, or 0 if it does not compile.
+    [[nodiscard]] auto get(shader_options const& options) -> unsigned int;
+
+    auto release() noexcept -> void;
+
+private:
+    [[nodiscard]] auto load(std::string const& path, std::string const& key) const -> unsigned int;
+    auto store(std::string const& path, std::string const& key, unsigned int program) const -> void;
+
+    std::string m_directory;
+    std::string m_driver;
+    bool m_binaries = false;
+    std::unordered_map<std::uint32_t, gl_program> m_programs;
+};
+
+// A cache file: a magic tag, the key the program was built from, the glProgramBinary format and
+// the binary itself.
+[[nodiscard]] auto encode_program_cache(std::string const& key,
+                                        std::uint32_t format,
+                                        char const* binary,
+                                        std::size_t size) -> std::string;
+
+// Finds the binary in the cache file `data` if it was written for `key`: it starts at `offset`
+// and runs to the end. False for another key and for truncated or foreign files.
+[[nodiscard]] auto decode_program_cache(std::string const& data,
+                                        std::string const& key,
+                                        std::uint32_t& format,
+                                        std::size_t& offset) -> bool;
+
+#endif // BEZIER_SDL_PROGRAM_CACHE_HPP
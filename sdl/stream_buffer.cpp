@@ -0,0 +1,141 @@
+#include "stream_buffer.hpp"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "trace.hpp"
+
+auto stream_buffer::create(GLenum const target, std::size_t const bytes) -> bool
+{
+    release();
+
+    m_target = target;
+    m_persistent = GLAD_GL_ARB_buffer_storage != 0 || GLVersion.major > 4 ||
+                   (GLVersion.major == 4 && GLVersion.minor >= 4);
+
+    return allocate(std::max<std::size_t>(bytes, 256));
+}
+
+auto stream_buffer::allocate(std::size_t const region_size) -> bool
+{
+    if(m_buffer.get() != 0) {
+        for(std::size_t r = 0; r < regions; ++r) {
+            wait(r);
+        }
+        if(m_mapped != nullptr) {
+            glBindBuffer(m_target, m_buffer.get());
+            glUnmapBuffer(m_target);
+            m_mapped = nullptr;
+        }
+        m_buffer.reset();
+    }
+
+    // Whole 256-byte steps keep every slice aligned for any attribute or uniform data.
+    m_region_size = (region_size + 255) / 256 * 256;
+    m_region = 0;
+
+    m_buffer.create();
+    glBindBuffer(m_target, m_buffer.get());
+
+    if(!m_persistent) {
+        glBufferData(m_target, static_cast<GLsizeiptr>(m_region_size), nullptr, GL_STREAM_DRAW);
+        return glGetError() == GL_NO_ERROR;
+    }
+
+    auto const size = static_cast<GLsizeiptr>(m_region_size * regions);
+    GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glBufferStorage(m_target, size, nullptr, flags);
+    m_mapped = static_cast<std::byte*>(glMapBufferRange(m_target, 0, size, flags));
+
+    if(m_mapped == nullptr) {
+        spdlog::error("Could not map a {} byte stream buffer", size);
+        return false;
+    }
+    return true;
+}
+
+auto stream_buffer::wait(std::size_t const region) -> void
+{
+    auto& sync = m_fences[region];
+
+    if(sync.get() == nullptr) {
+        return;
+    }
+
+    trace_span const span{ "stream_wait", "gpu" };
+
+    for(;;) {
+        auto const status = glClientWaitSync(sync.get(), GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+
+        if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            break;
+        }
+        if(status == GL_WAIT_FAILED) {
+            spdlog::error("Waiting for a stream buffer fence failed");
+            break;
+        }
+    }
+
+    sync.reset();
+}
+
+auto stream_buffer::map(std::size_t const bytes) -> void*
+{
+    // glMapBufferRange rejects an empty range.
+    if(bytes == 0) {
+        return nullptr;
+    }
+
+    if(bytes > m_region_size && !allocate(std::max(bytes, m_region_size * 2))) {
+        return nullptr;
+    }
+
+    if(m_persistent) {
+        wait(m_region);
+        return m_mapped + m_region * m_region_size;
+    }
+
+    // Orphan the old store: frames still reading it keep it alive, this one gets a fresh one.
+    glBindBuffer(m_target, m_buffer.get());
+    glBufferData(m_target, static_cast<GLsizeiptr>(m_region_size), nullptr, GL_STREAM_DRAW);
+
+    return glMapBufferRange(m_target,
+                            0,
+                            static_cast<GLsizeiptr>(bytes),
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
+auto stream_buffer::unmap() -> std::size_t
+{
+    if(m_persistent) {
+        return m_region * m_region_size;
+    }
+
+    glBindBuffer(m_target, m_buffer.get());
+    glUnmapBuffer(m_target);
+    return 0;
+}
+
+auto stream_buffer::fence() -> void
+{
+    if(m_persistent) {
+        m_fences[m_region].reset(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        m_region = (m_region + 1) % regions;
+    }
+}
+
+auto stream_buffer::release() noexcept -> void
+{
+    for(auto& sync : m_fences) {
+        sync.reset();
+    }
+
+    if(m_mapped != nullptr) {
+        glBindBuffer(m_target, m_buffer.get());
+        glUnmapBuffer(m_target);
+        m_mapped = nullptr;
+    }
+    m_buffer.reset();
+}
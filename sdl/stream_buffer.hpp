@@ -0,0 +1,64 @@
+#ifndef BEZIER_SDL_STREAM_BUFFER_HPP
+#define BEZIER_SDL_STREAM_BUFFER_HPP
+
+#include <array>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "gl_handle.hpp"
+
+// A buffer rewritten every frame without stalling on the GPU. With buffer storage (GL 4.4 or
+// ARB_buffer_storage) it is one persistently mapped allocation cut into `regions` slices used
+// in turn; a fence per slice keeps the CPU off a slice the GPU may still read. Without it each
+// frame orphans the whole store and maps the fresh one, letting the driver do the renaming.
+//
+//     auto* p = stream.map(bytes);   // write the frame's data to p
+//     auto const offset = stream.unmap();
+//     ... point attributes at `offset` and draw ...
+//     stream.fence();
+class stream_buffer
+{
+public:
+    static constexpr std::size_t regions = 3;
+
+    // Creates the buffer with room for `bytes` per frame.
+    [[nodiscard]] auto create(GLenum target, std::size_t bytes) -> bool;
+
+    // Room for this frame's `bytes`, growing the buffer if they do not fit. Waits only if the
+    // GPU is still reading the slice from `regions` frames ago. nullptr if mapping fails, and for
+    // 0 bytes, which map nothing; `unmap` only follows a successful map.
+    [[nodiscard]] auto map(std::size_t bytes) -> void*;
+
+    // Ends the writes started by `map`; returns where they start in the buffer, in bytes.
+    auto unmap() -> std::size_t;
+
+    // Marks the current slice as read by the commands issued since `unmap`, and moves on.
+    auto fence() -> void;
+
+    [[nodiscard]] auto id() const noexcept -> unsigned int
+    {
+        return m_buffer.get();
+    }
+
+    [[nodiscard]] auto persistent() const noexcept -> bool
+    {
+        return m_persistent;
+    }
+
+    auto release() noexcept -> void;
+
+private:
+    [[nodiscard]] auto allocate(std::size_t region_size) -> bool;
+    auto wait(std::size_t region) -> void;
+
+    GLenum m_target = GL_ARRAY_BUFFER;
+    gl_buffer m_buffer;
+    bool m_persistent = false;
+    std::size_t m_region_size = 0;
+    std::size_t m_region = 0;
+    std::byte* m_mapped = nullptr;
+    std::array<gl_sync, regions> m_fences;
+};
+
+#endif // BEZIER_SDL_STREAM_BUFFER_HPP
@@ -0,0 +1,247 @@
+// Unit checks for the CPU side of the GPU demo: band building in `glyph_buffer`, the frame time
+// statistics of `frame_history`, and the program cache file format. None of it touches GL, so it
+// runs without a context.
+//
+//   BezierTests
+//
+// Every failed check is logged with its line; the exit code is 1 if any failed.
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "frame_stats.hpp"
+#include "glyph_buffer.hpp"
+#include "program_cache.hpp"
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                                                               \
+    do {                                                                                                               \
+        if(!(condition)) {                                                                                             \
+            spdlog::error("{}:{}: check failed: {}", __FILE__, __LINE__, #condition);                                  \
+            ++g_failures;                                                                                              \
+        }                                                                                                              \
+    } while(false)
+
+// A straight quadratic from `a` to `b`.
+auto line(point const a, point const b) -> curve
+{
+    return curve{ a, point{ (a.x + b.x) / 2.0F, (a.y + b.y) / 2.0F }, b };
+}
+
+// The curve indices of strip `b` on `axis` (0 horizontal, 1 vertical) of glyph `id`, in the order
+// the shader walks them.
+auto strip(glyph_buffer const& glyphs, std::uint32_t const id, int const axis, std::uint32_t const b)
+    -> std::vector<std::uint32_t>
+{
+    auto const& data = glyphs.band_data();
+    auto const& e = glyphs.entry(id);
+    auto const header = 4 * (static_cast<std::size_t>(e.band_base) + 2 + static_cast<std::size_t>(axis) * e.bands + b);
+    auto const first = 4 * static_cast<std::size_t>(data[header]);
+
+    return std::vector<std::uint32_t>(data.begin() + first, data.begin() + first + data[header + 1]);
+}
+
+auto float_at(std::vector<std::uint32_t> const& data, std::size_t const i) -> float
+{
+    float f = 0.0F;
+    std::memcpy(&f, &data[i], sizeof(f));
+    return f;
+}
+
+auto test_band_counts() -> void
+{
+    glyph_buffer glyphs;
+
+    auto const empty = glyphs.add({});
+    CHECK(glyphs.entry(empty).count == 0);
+    CHECK(glyphs.entry(empty).bands == 0);
+    // Even an empty glyph has its two header texels, so every entry's band_base is valid.
+    CHECK(glyphs.band_texel_count() == 2);
+
+    std::vector<curve> curves;
+    for(int i = 0; i < 5; ++i) {
+        curves.push_back(line(point{ 0.0F, static_cast<float>(i) }, point{ 1.0F, static_cast<float>(i) }));
+    }
+    CHECK(glyphs.entry(glyphs.add(curves)).bands == 3);
+
+    curves.resize(300, line(point{ 0.0F, 0.0F }, point{ 1.0F, 1.0F }));
+    CHECK(glyphs.entry(glyphs.add(curves)).bands == max_glyph_bands);
+
+    // Degenerate curves are dropped before anything is counted.
+    auto const dot = glyphs.add({ curve{ point{ 1.0F, 1.0F }, point{ 1.0F, 1.0F }, point{ 1.0F, 1.0F } } });
+    CHECK(glyphs.entry(dot).count == 0);
+    CHECK(glyphs.curve_count() == 305);
+}
+
+auto test_band_header() -> void
+{
+    glyph_buffer glyphs;
+    glyphs.add({ line(point{ 0.0F, 0.0F }, point{ 1.0F, 0.0F }) });
+
+    auto const id = glyphs.add({ line(point{ -1.0F, 2.0F }, point{ 3.0F, 4.0F }) });
+    auto const& e = glyphs.entry(id);
+    auto const& data = glyphs.band_data();
+    auto const base = 4 * static_cast<std::size_t>(e.band_base);
+
+    CHECK(float_at(data, base) == -1.0F);
+    CHECK(float_at(data, base + 1) == 2.0F);
+    CHECK(float_at(data, base + 2) == 3.0F);
+    CHECK(float_at(data, base + 3) == 4.0F);
+    CHECK(data[base + 4] == e.bands);
+    CHECK(data[base + 5] == 1);
+    CHECK(data[base + 6] == 1);
+    CHECK(data.size() % 4 == 0);
+}
+
+auto test_strip_membership() -> void
+{
+    glyph_buffer glyphs;
+
+    // One curve first, so the glyph under test starts at curve 1 and its lists hold global indices.
+    glyphs.add({ line(point{ 0.0F, 0.0F }, point{ 1.0F, 1.0F }) });
+
+    // Four curves give two strips per axis over the unit box: y (and x) below and above 0.5.
+    auto const id = glyphs.add({
+        line(point{ 0.0F, 0.0F }, point{ 1.0F, 0.0F }), // 1: bottom, full width
+        line(point{ 0.0F, 0.1F }, point{ 0.2F, 0.1F }), // 2: bottom, left
+        line(point{ 0.8F, 0.9F }, point{ 1.0F, 0.9F }), // 3: top, right
+        line(point{ 0.0F, 1.0F }, point{ 1.0F, 1.0F }), // 4: top, full width
+    });
+    CHECK(glyphs.entry(id).bands == 2);
+
+    // Horizontal strips run by descending maximum x; ties keep their order.
+    CHECK((strip(glyphs, id, 0, 0) == std::vector<std::uint32_t>{ 1, 2 }));
+    CHECK((strip(glyphs, id, 0, 1) == std::vector<std::uint32_t>{ 3, 4 }));
+
+    // Vertical strips run by descending maximum y.
+    CHECK((strip(glyphs, id, 1, 0) == std::vector<std::uint32_t>{ 4, 2, 1 }));
+    CHECK((strip(glyphs, id, 1, 1) == std::vector<std::uint32_t>{ 4, 3, 1 }));
+}
+
+auto test_strip_edges() -> void
+{
+    glyph_buffer glyphs;
+
+    // The middle curve lies exactly on the edge between the two horizontal strips and must be in
+    // both; the top one spans the whole box and is in both as well.
+    auto const id = glyphs.add({
+        line(point{ 0.0F, 0.0F }, point{ 0.5F, 0.0F }),
+        line(point{ 0.0F, 0.5F }, point{ 0.7F, 0.5F }),
+        line(point{ 0.0F, 0.0F }, point{ 0.2F, 1.0F }),
+        line(point{ 0.9F, 1.0F }, point{ 1.0F, 1.0F }),
+    });
+    CHECK(glyphs.entry(id).bands == 2);
+    CHECK((strip(glyphs, id, 0, 0) == std::vector<std::uint32_t>{ 1, 0, 2 }));
+    CHECK((strip(glyphs, id, 0, 1) == std::vector<std::uint32_t>{ 3, 1, 2 }));
+}
+
+auto test_frame_history() -> void
+{
+    frame_history history;
+
+    CHECK(history.count() == 0);
+    CHECK(history.mean() == 0.0);
+    CHECK(history.max() == 0.0);
+    CHECK(history.percentile(0.5) == 0.0);
+
+    // Added out of order; percentiles go by rank, not by arrival.
+    for(int i = 100; i >= 1; --i) {
+        history.add(static_cast<double>(i));
+    }
+    CHECK(history.count() == 100);
+    CHECK(history.mean() == 50.5);
+    CHECK(history.max() == 100.0);
+    CHECK(history.percentile(0.0) == 1.0);
+    CHECK(history.percentile(0.5) == 50.0);
+    CHECK(history.percentile(0.95) == 95.0);
+    CHECK(history.percentile(0.951) == 96.0);
+    CHECK(history.percentile(1.0) == 100.0);
+
+    // Past capacity the oldest samples go first.
+    frame_history full;
+    for(int i = 1; i <= 300; ++i) {
+        full.add(static_cast<double>(i));
+    }
+    CHECK(full.count() == frame_history::capacity);
+    CHECK(full.percentile(0.0) == 61.0);
+    CHECK(full.max() == 300.0);
+    CHECK(full.mean() == 180.5);
+}
+
+auto test_frame_buckets() -> void
+{
+    frame_history history;
+
+    // Bucket i holds values below bucket_limits[i] and at or above the previous limit; the last
+    // bucket is open.
+    for(double const v : { 0.25, 0.5, 0.75, 3.0, 16.0, 40.0, 1000.0 }) {
+        history.add(v);
+    }
+
+    auto const counts = history.buckets();
+    std::array<std::size_t, frame_history::bucket_limits.size() + 1> const expected = { 1, 2, 0, 1, 0, 0, 1, 2 };
+    CHECK(counts == expected);
+
+    CHECK(frame_history{}.buckets() == (std::array<std::size_t, frame_history::bucket_limits.size() + 1>{}));
+}
+
+auto test_program_cache_format() -> void
+{
+    std::string const key = "vendor\nrenderer\n3.3\nsource";
+    std::string const binary{ "\x01\x02\x00\x03", 4 };
+    auto const file = encode_program_cache(key, 0x8741, binary.data(), binary.size());
+
+    std::uint32_t format = 0;
+    std::size_t offset = 0;
+    CHECK(decode_program_cache(file, key, format, offset));
+    CHECK(format == 0x8741);
+    CHECK(file.substr(offset) == binary);
+
+    // An empty binary is still a well-formed file.
+    std::string const none;
+    auto const empty = encode_program_cache(key, 1, none.data(), 0);
+    CHECK(decode_program_cache(empty, key, format, offset) && offset == empty.size());
+
+    // Another driver or source, including one the stored key merely starts with, misses.
+    CHECK(!decode_program_cache(file, key + "!", format, offset));
+    CHECK(!decode_program_cache(file, key.substr(0, key.size() - 1), format, offset));
+    CHECK(!decode_program_cache(file, "", format, offset));
+
+    // Truncated anywhere, or with bytes appended, the file is rejected.
+    for(std::size_t size = 0; size < file.size(); ++size) {
+        CHECK(!decode_program_cache(file.substr(0, size), key, format, offset));
+    }
+    CHECK(!decode_program_cache(file + '\0', key, format, offset));
+
+    auto foreign = file;
+    foreign[0] = 'X';
+    CHECK(!decode_program_cache(foreign, key, format, offset));
+}
+
+} // namespace
+
+auto main() -> int
+{
+    test_band_counts();
+    test_band_header();
+    test_strip_membership();
+    test_strip_edges();
+    test_frame_history();
+    test_frame_buckets();
+    test_program_cache_format();
+
+    if(g_failures != 0) {
+        spdlog::error("{} checks failed", g_failures);
+        return 1;
+    }
+    spdlog::info("All checks passed");
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "text_run.hpp"
+
+#include <algorithm>
+
+auto glyph_frame(glyph_entry const& e) -> glm::vec4
+{
+    return glm::vec4{ e.min.x, e.min.y, e.max.x, e.max.y };
+}
+
+auto layout_text(glyph_buffer const& glyphs,
+                 FT_Face face,
+                 std::uint32_t const first_id,
+                 std::string const& text,
+                 glm::vec4 const& color,
+                 std::vector<glyph_instance>& instances) -> void
+{
+    float const line_height = static_cast<float>(face->height) / static_cast<float>(face->units_per_EM);
+    glm::vec2 pen{ 0.0F, 0.0F };
+
+    for(char const ch : text) {
+        if(ch == '\n') {
+            pen = glm::vec2{ 0.0F, pen.y - line_height };
+            continue;
+        }
+
+        auto const code = static_cast<FT_ULong>(static_cast<unsigned char>(ch));
+        auto const& e = glyphs.entry(first_id + FT_Get_Char_Index(face, code));
+
+        if(e.count != 0) {
+            instances.push_back(glyph_instance{
+                pen, 1.0F, glyph_frame(e), color, static_cast<std::int32_t>(e.band_base) });
+        }
+
+        pen.x += e.advance;
+    }
+}
+
+auto fit_instances(std::vector<glyph_instance>& instances, float const half_extent) -> void
+{
+    if(instances.empty()) {
+        return;
+    }
+
+    glm::vec2 lo{ 1e30F, 1e30F };
+    glm::vec2 hi{ -1e30F, -1e30F };
+
+    for(auto const& i : instances) {
+        lo = glm::min(lo, i.origin + glm::vec2{ i.frame.x, i.frame.y } * i.scale);
+        hi = glm::max(hi, i.origin + glm::vec2{ i.frame.z, i.frame.w } * i.scale);
+    }
+
+    glm::vec2 const center = (lo + hi) / 2.0F;
+    float const s = 2.0F * half_extent / std::max({ hi.x - lo.x, hi.y - lo.y, 1e-6F });
+
+    place_instances(instances, 0, center * -s, s);
+}
+
+auto place_instances(std::vector<glyph_instance>& instances,
+                     std::size_t const first,
+                     glm::vec2 const offset,
+                     float const scale) -> void
+{
+    for(auto i = instances.begin() + static_cast<std::ptrdiff_t>(first); i != instances.end(); ++i) {
+        i->origin = offset + i->origin * scale;
+        i->scale *= scale;
+    }
+}
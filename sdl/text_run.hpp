@@ -0,0 +1,49 @@
+#ifndef BEZIER_SDL_TEXT_RUN_HPP
+#define BEZIER_SDL_TEXT_RUN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "glyph_buffer.hpp"
+
+// One glyph of a run, as fed to the shader per instance. The quad covers `frame` in glyph units
+// (em for font glyphs), grown by a pixel on screen, and is placed at `origin + coord * scale`
+// in model space.
+struct glyph_instance
+{
+    glm::vec2 origin;
+    float scale;
+    glm::vec4 frame;
+    glm::vec4 color;
+    std::int32_t band_base;
+};
+
+// The box of a glyph's control points as a frame: (min.x, min.y, max.x, max.y).
+[[nodiscard]] auto glyph_frame(glyph_entry const& e) -> glm::vec4;
+
+// Lays `text` out left to right from the origin in em units, one line per '\n', and appends an
+// instance for every glyph that has curves. `first_id` is what `glyph_buffer::add_font` returned
+// for `face`. Bytes are taken as Latin-1 code points.
+auto layout_text(glyph_buffer const& glyphs,
+                 FT_Face face,
+                 std::uint32_t first_id,
+                 std::string const& text,
+                 glm::vec4 const& color,
+                 std::vector<glyph_instance>& instances) -> void;
+
+// Maps instances [first, end) from their own space into model space: scaled by `scale`, then
+// moved by `offset`.
+auto place_instances(std::vector<glyph_instance>& instances, std::size_t first, glm::vec2 offset, float scale)
+    -> void;
+
+// Scales and centres the instances so all their frames fit in [-half_extent, half_extent]².
+auto fit_instances(std::vector<glyph_instance>& instances, float half_extent) -> void;
+
+#endif // BEZIER_SDL_TEXT_RUN_HPP